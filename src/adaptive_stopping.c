@@ -0,0 +1,157 @@
+/*
+ * adaptive_stopping.c - Sequential runs that stop at a target precision
+ */
+
+#include "adaptive_stopping.h"
+#include "batch_kernel.h"
+
+// ============================================================================
+// TARGETS
+// ============================================================================
+
+void precision_targets_init(PrecisionTargets* t, int max_patients) {
+    for (int e = 0; e < N_ENDPOINTS; e++) t->half_width[e] = 0;
+    t->z = 1.96;
+    t->min_patients = 5000;
+    t->max_patients = max_patients;
+}
+
+int precision_targets_parse(PrecisionTargets* t, const char* spec) {
+    char buffer[256];
+    if (snprintf(buffer, sizeof(buffer), "%s", spec) >= (int)sizeof(buffer)) {
+        fprintf(stderr, "Error: precision target spec is longer than %d characters\n",
+                (int)sizeof(buffer) - 1);
+        return -1;
+    }
+
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        const char* text = eq ? eq + 1 : item;
+        char* end;
+
+        if (eq && strncmp(item, "min=", 4) == 0) {
+            long patients = strtol(text, &end, 10);
+            if (end == text || *end != '\0' || patients <= 0 || patients > INT_MAX) {
+                fprintf(stderr, "Error: bad precision target \"%s\" (min expects a positive "
+                                "integer)\n", item);
+                return -1;
+            }
+            t->min_patients = (int)patients;
+            continue;
+        }
+
+        double value = strtod(text, &end);
+        if (end == text || *end != '\0' || !isfinite(value) || value <= 0) {
+            fprintf(stderr, "Error: bad precision target \"%s\" (expected a positive number)\n", item);
+            return -1;
+        }
+
+        if (!eq) {
+            for (int e = 0; e < N_ENDPOINTS; e++) t->half_width[e] = value;
+            continue;
+        }
+
+        *eq = '\0';
+        Endpoint e;
+        if (endpoint_from_name(item, &e) == 0) {
+            t->half_width[e] = value;
+        } else if (strcmp(item, "z") == 0) {
+            t->z = value;
+        } else {
+            fprintf(stderr, "Error: unknown precision target \"%s\" (endpoints: success, "
+                            "tolerance, addiction, pain_reduction; or z, min)\n", item);
+            return -1;
+        }
+    }
+
+    // z and min alone would stop after the first batch with nothing measured
+    for (int e = 0; e < N_ENDPOINTS; e++) {
+        if (t->half_width[e] > 0) return 0;
+    }
+    fprintf(stderr, "Error: precision target spec \"%s\" sets no endpoint half-width\n", spec);
+    return -1;
+}
+
+/*
+ * Standard error the stopping rule judges an endpoint by. Rates use the
+ * Agresti-Coull interval, p~ = (x + z^2/2) / (n + z^2) over n + z^2
+ * patients: the Wald SE is 0 while a rare endpoint has no events (or only
+ * events) yet, which would stop the run on its first batch.
+ */
+static double stopping_standard_error(const PrecisionTargets* t, const OutcomeStats* s, Endpoint e) {
+    double se;
+    double p = outcome_stats_endpoint(s, e, &se);
+    if (e == ENDPOINT_PAIN_REDUCTION) return se;
+
+    const Welford* w = &s->pain_reduction;
+    if (s->weight <= 0 || w->sum_w2 <= 0) return INFINITY;
+    double n_eff = w->sum_w * w->sum_w / w->sum_w2;
+    double z2 = t->z * t->z;
+    double adjusted = (p * n_eff + z2 / 2) / (n_eff + z2);
+    return sqrt(adjusted * (1 - adjusted) / (n_eff + z2));
+}
+
+int precision_targets_met(const PrecisionTargets* t, const OutcomeStats* s) {
+    for (int e = 0; e < N_ENDPOINTS; e++) {
+        if (t->half_width[e] <= 0) continue;
+        double se = stopping_standard_error(t, s, (Endpoint)e);
+        if (t->z * se > t->half_width[e]) return 0;
+    }
+    return 1;
+}
+
+// Patients the least precise endpoint is projected to need
+static double projected_patients(const PrecisionTargets* t, const OutcomeStats* s) {
+    double needed = 0;
+    for (int e = 0; e < N_ENDPOINTS; e++) {
+        if (t->half_width[e] <= 0) continue;
+        double se = stopping_standard_error(t, s, (Endpoint)e);
+        double ratio = t->z * se / t->half_width[e];
+        if (s->n * ratio * ratio > needed) needed = s->n * ratio * ratio;
+    }
+    return needed;
+}
+
+// ============================================================================
+// SEQUENTIAL DRIVER
+// ============================================================================
+
+static void print_batch(int batch, const PrecisionTargets* t, const OutcomeStats* s) {
+    printf("  Batch %2d: %8ld patients ", batch, s->n);
+    for (int e = 0; e < N_ENDPOINTS; e++) {
+        double se;
+        double estimate = outcome_stats_endpoint(s, (Endpoint)e, &se);
+        se = stopping_standard_error(t, s, (Endpoint)e);
+        const char* mark = t->half_width[e] <= 0 ? " " : t->z * se <= t->half_width[e] ? "*" : " ";
+        printf(" %s %.4f +/- %.4f%s", endpoint_name((Endpoint)e), estimate, t->z * se, mark);
+    }
+    printf("\n");
+}
+
+int simulate_until_precise(PopulationSoA* pop, const SamplingPlan* plan,
+                           const DoseSchedule* schedule, const OutcomeSink* sink,
+                           const PrecisionTargets* t) {
+    int max_patients = t->max_patients < pop->n ? t->max_patients : pop->n;
+    int done = 0;
+    int next = t->min_patients < max_patients ? t->min_patients : max_patients;
+
+    for (int batch = 1; done < max_patients; batch++) {
+        generate_population_range(pop, done, next, plan);
+        simulate_population_range(pop, schedule, done, next, sink);
+        done = next;
+        print_batch(batch, t, sink->stats);
+
+        if (precision_targets_met(t, sink->stats)) break;
+
+        // Aim 5% past the projection; at least one kernel block, at most double
+        double target = 1.05 * projected_patients(t, sink->stats);
+        if (target > 2.0 * done) target = 2.0 * done;
+        if (target < done + BATCH_KERNEL_BLOCK) target = done + BATCH_KERNEL_BLOCK;
+        next = target < max_patients ? (int)target : max_patients;
+    }
+
+    printf("  Targets %s after %d of %d patients (%.1f%%)\n",
+           precision_targets_met(t, sink->stats) ? "met" : "NOT met", done, max_patients,
+           100.0 * done / max_patients);
+    return done;
+}
@@ -0,0 +1,68 @@
+/*
+ * adaptive_stopping.h - Sequential runs that stop at a target precision
+ *
+ * Instead of always simulating the full population, patients are generated
+ * and simulated in growing batches. After every batch the confidence
+ * interval of each targeted endpoint is compared with its target
+ * half-width, and the run stops as soon as all targets are met (or the
+ * population capacity is reached). The next batch size is the sample the
+ * worst endpoint is projected to need, SE ~ 1/sqrt(n), capped at doubling
+ * the patients simulated so far. Rate endpoints are judged by the
+ * Agresti-Coull interval, which stays open while an endpoint has no
+ * events yet, so rare endpoints do not stop on the first batch.
+ *
+ * Patients keep their population index, so a stopped run holds exactly
+ * patients [0, n) of the full-size run with the same seed.
+ *
+ * Looking at the intervals after every batch makes the final coverage
+ * slightly lower than nominal; raise z for confirmatory runs.
+ */
+
+#ifndef ADAPTIVE_STOPPING_H
+#define ADAPTIVE_STOPPING_H
+
+#include "patient_sim.h"
+#include "population_soa.h"
+#include "population_gen.h"
+#include "outcome_record.h"
+#include "outcome_stats.h"
+#include "dose_schedule.h"
+
+typedef struct {
+    double half_width[N_ENDPOINTS];  // Target CI half-width; <= 0 leaves the endpoint free
+    double z;                        // Normal quantile of the interval (1.96 = 95%)
+    int min_patients;                // First batch
+    int max_patients;                // Stop here even if targets are missed
+} PrecisionTargets;
+
+// No endpoint targeted, z = 1.96, first batch of 5000 patients
+void precision_targets_init(PrecisionTargets* t, int max_patients);
+
+/*
+ * Parses a comma-separated spec. A bare number sets every endpoint's
+ * half-width; otherwise key=value pairs with keys success, tolerance,
+ * addiction, pain_reduction, z and min, e.g.
+ *
+ *   0.005
+ *   success=0.005,pain_reduction=0.01,z=2.576
+ *
+ * Rates are fractions, so 0.005 is +/- 0.5 percentage points; min is a
+ * patient count. At least one endpoint must be targeted. Returns 0, or -1
+ * with a message.
+ */
+int precision_targets_parse(PrecisionTargets* t, const char* spec);
+
+// Nonzero once every targeted endpoint of s is within its half-width
+int precision_targets_met(const PrecisionTargets* t, const OutcomeStats* s);
+
+/*
+ * Generates and simulates batches of pop (capacity t->max_patients, plan
+ * may be NULL) under schedule until the targets are met. sink->stats is
+ * required and ends up holding the merged statistics. Returns the number
+ * of patients simulated.
+ */
+int simulate_until_precise(PopulationSoA* pop, const SamplingPlan* plan,
+                           const DoseSchedule* schedule, const OutcomeSink* sink,
+                           const PrecisionTargets* t);
+
+#endif // ADAPTIVE_STOPPING_H
@@ -0,0 +1,78 @@
+/*
+ * alias_table.c - O(1) categorical sampling (Walker/Vose alias method)
+ */
+
+#include "alias_table.h"
+
+int alias_table_init(AliasTable* t, const float* probs, int n) {
+    if (n < 1 || n > ALIAS_MAX_CATEGORIES) return -1;
+
+    double total = 0;
+    for (int k = 0; k < n; k++) {
+        if (!(probs[k] >= 0)) return -1;
+        total += probs[k];
+    }
+    if (!(total > 0)) return -1;
+
+    // Vose's construction in double so rounding does not bias small buckets
+    double scaled[ALIAS_MAX_CATEGORIES];
+    int small[ALIAS_MAX_CATEGORIES], large[ALIAS_MAX_CATEGORIES];
+    int n_small = 0, n_large = 0;
+
+    for (int k = 0; k < n; k++) {
+        scaled[k] = probs[k] * n / total;
+        if (scaled[k] < 1.0) {
+            small[n_small++] = k;
+        } else {
+            large[n_large++] = k;
+        }
+    }
+
+    while (n_small > 0 && n_large > 0) {
+        int s = small[--n_small];
+        int l = large[--n_large];
+
+        t->accept[s] = (float)scaled[s];
+        t->alias[s] = l;
+
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            small[n_small++] = l;
+        } else {
+            large[n_large++] = l;
+        }
+    }
+
+    // Leftovers are full buckets up to rounding
+    while (n_large > 0) {
+        int l = large[--n_large];
+        t->accept[l] = 1.0f;
+        t->alias[l] = l;
+    }
+    while (n_small > 0) {
+        int s = small[--n_small];
+        t->accept[s] = 1.0f;
+        t->alias[s] = s;
+    }
+
+    t->n = n;
+    return 0;
+}
+
+int alias_table_draw(const AliasTable* t) {
+    return alias_table_sample(t, random_uniform());
+}
+
+void alias_table_sample_batch(const AliasTable* t, const float* u, uint8_t* out, int count) {
+    const float n = (float)t->n;
+    const int last = t->n - 1;
+
+    #pragma omp simd
+    for (int i = 0; i < count; i++) {
+        float scaled = u[i] * n;
+        int bucket = (int)scaled;
+        bucket = bucket < last ? bucket : last;
+        float frac = scaled - (float)bucket;
+        out[i] = (uint8_t)(frac < t->accept[bucket] ? bucket : t->alias[bucket]);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * alias_table.h - O(1) categorical sampling (Walker/Vose alias method)
+ *
+ * A table is built once per distribution. A draw then costs one uniform,
+ * one multiply and one lookup regardless of the number of categories:
+ *
+ *   bucket = floor(u * n),  frac = u * n - bucket
+ *   category = frac < accept[bucket] ? bucket : alias[bucket]
+ *
+ * Splitting a single uniform keeps one population stream draw per
+ * categorical covariate; with 24-bit uniforms the acceptance test keeps
+ * 24 - log2(n) bits of resolution, ample for cohort-sized tables.
+ */
+
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include "patient_sim.h"
+#include <stdint.h>
+
+#define ALIAS_MAX_CATEGORIES 256  // Categories must fit a uint8_t column
+
+typedef struct {
+    int n;
+    float accept[ALIAS_MAX_CATEGORIES];   // Probability of keeping the bucket's own category
+    int32_t alias[ALIAS_MAX_CATEGORIES];  // Category taken otherwise (int32 for gathers)
+} AliasTable;
+
+// Builds the table for weights probs[0..n); weights need not sum to one.
+// Returns 0, or -1 if n is out of range or the weights are not a
+// distribution (negative or zero total).
+int alias_table_init(AliasTable* t, const float* probs, int n);
+
+// u is a uniform on [0, 1)
+static inline int alias_table_sample(const AliasTable* t, float u) {
+    float scaled = u * (float)t->n;
+    int bucket = (int)scaled;
+    bucket = bucket < t->n - 1 ? bucket : t->n - 1;  // u * n may round up to n
+    float frac = scaled - (float)bucket;
+    return frac < t->accept[bucket] ? bucket : t->alias[bucket];
+}
+
+// Draws from the calling thread's bound stream, like random_categorical()
+int alias_table_draw(const AliasTable* t);
+
+// out[i] = alias_table_sample(t, u[i]) for i in [0, count); vectorizes
+void alias_table_sample_batch(const AliasTable* t, const float* u, uint8_t* out, int count);
+
+#endif // ALIAS_TABLE_H
@@ -0,0 +1,705 @@
+/*
+ * batch_kernel.c - SIMD batch treatment kernel
+ *
+ * Lane state is kept in SIM_LANES-wide arrays and every per-timestep
+ * computation runs inside a `#pragma omp simd` loop. Patients only leave
+ * the treatment loop at day boundaries, so a lane that discontinues (or
+ * completes) is refilled with the next patient of the block at the next
+ * day boundary; once the block runs dry, the lane is masked off.
+ *
+ * Simulation cost per patient is driven by the number of days simulated,
+ * which ranges from 1 to the treatment length. Both levels of scheduling work
+ * longest-predicted-first: lanes are filled in descending predicted cost
+ * so a block ends on short patients instead of a few long ones running on
+ * otherwise masked lanes, and blocks are handed to threads in descending
+ * predicted cost so the last blocks of the parallel loop are the cheap
+ * ones.
+ *
+ * The treatment grid is a run parameter (sim_config.h). The block loop is
+ * instantiated with a constant timestep count for the common grids so the
+ * per-timestep loop keeps a fixed trip count; other grids run a generic
+ * instance with the count as an argument.
+ *
+ * Formulations are resolved per protocol when lanes are loaded. Sustained
+ * release only changes the absorption coefficients, so it shares the
+ * immediate-release loop. Zero-order release needs a depot per compound
+ * and the two-compartment model a peripheral compartment; each grid
+ * instance comes in a variant for each combination, so immediate-release
+ * protocols in a sweep keep the loop without the depot and one-compartment
+ * runs never touch the peripheral state. The tolerance model of the run
+ * (tolerance_model.h) is a third variant dimension, so its update is
+ * inlined into the lane loop instead of dispatched per timestep.
+ * Withdrawal (withdrawal_model.h) is only evaluated at day boundaries.
+ *
+ * Adverse events are sampled by thinning (RngThinning in sim_rng.h): each
+ * lane counts down to its next candidate timestep, and only candidates
+ * draw from the lane's stream.
+ */
+
+#include "batch_kernel.h"
+#include "sim_kernel.h"
+#include "pk_engine.h"
+#include "sim_rng.h"
+#include "progress.h"
+#include "sim_config.h"
+#include "tolerance_model.h"
+#include "withdrawal_model.h"
+
+#define LANE_ALIGN __attribute__((aligned(64)))
+
+typedef struct {
+    // PK recurrence coefficients and compartment amounts, per compound
+    float pk_decay_e[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_decay_a[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_transfer[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_dose_scale[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_to_gut[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_to_central[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_gut[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_central[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+
+    // Peripheral compartment; only touched by the two-compartment instances
+    float pk_from_peripheral[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_to_peripheral[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_decay_p[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_transfer_p[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_peripheral[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+
+    // Zero-order release depot; only touched by the depot instances
+    float pk_to_depot[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_release_per_mg[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_depot[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+    float pk_release_rate[PK_N_COMPOUNDS][SIM_LANES] LANE_ALIGN;
+
+    // Patient-scaled mg of each dose event in the lane's current phase
+    float event_dose[PK_N_COMPOUNDS][DOSE_MAX_EVENTS][SIM_LANES] LANE_ALIGN;
+    int phase[SIM_LANES];
+
+    float baseline_pain[SIM_LANES] LANE_ALIGN;
+    float analgesia_gain[SIM_LANES] LANE_ALIGN;
+    float adherence[SIM_LANES] LANE_ALIGN;
+    float tolerance[SIM_LANES] LANE_ALIGN;
+    float cumulative_analgesia[SIM_LANES] LANE_ALIGN;
+    float max_beta_arrestin[SIM_LANES] LANE_ALIGN;
+    float total_cost[SIM_LANES] LANE_ALIGN;
+    float trial_pain_sum[SIM_LANES] LANE_ALIGN;
+    float active[SIM_LANES] LANE_ALIGN;  // 1.0 = lane holds a patient, 0.0 = masked
+    int patient[SIM_LANES];
+    int day[SIM_LANES];
+    int adverse_events[SIM_LANES];
+    int ae_countdown[SIM_LANES];  // Timesteps to the next adverse-event candidate
+    WithdrawalEpisode withdrawal[SIM_LANES];
+    float trace_pain[SIM_LANES][SIMULATION_DAYS];       // Daily averages so far
+    float trace_analgesia[SIM_LANES][SIMULATION_DAYS];
+    RngStream ae_rng[SIM_LANES];
+    RngStream adherence_rng[SIM_LANES];
+    RngThinning ae_thinning;
+} LaneState;
+
+// Dose-independent per-patient constants. Computed once per block and
+// shared by every protocol of a sweep.
+typedef struct {
+    float decay_e[PK_N_COMPOUNDS];
+    float decay_a[PK_N_COMPOUNDS];
+    float transfer[PK_N_COMPOUNDS];
+    float to_gut[PK_N_COMPOUNDS];
+    float to_central[PK_N_COMPOUNDS];
+    float from_peripheral[PK_N_COMPOUNDS];  // Two-compartment terms, 0 otherwise
+    float to_peripheral[PK_N_COMPOUNDS];
+    float decay_p[PK_N_COMPOUNDS];
+    float transfer_p[PK_N_COMPOUNDS];
+    float sr_decay_a[PK_N_COMPOUNDS];  // Absorption under sustained release
+    float sr_transfer[PK_N_COMPOUNDS];
+    float sr_transfer_p[PK_N_COMPOUNDS];
+    float dose_scale[PK_N_COMPOUNDS];  // Reductions for elderly or impaired
+    float analgesia_gain;
+    float baseline_pain;
+    float adherence;
+    float predicted_days;
+    uint32_t patient_id;
+} PatientConstants;
+
+// ============================================================================
+// COST MODEL
+// ============================================================================
+
+// Expected days simulated. The daily adherence check keeps a patient with
+// probability `adherence`, so the number of days is roughly geometric,
+// truncated at the treatment length. Baseline pain was checked as a
+// predictor too and carries almost no signal; adherence dominates.
+static inline float predicted_treatment_days(float adherence, int days) {
+    float keep = sim_minf(adherence, 0.999f);
+    return (1.0f - powf(keep, days)) / (1.0f - keep);
+}
+
+typedef struct {
+    float cost;
+    int index;
+} CostOrder;
+
+// Descending cost; index breaks ties so the order is deterministic
+static int compare_cost_descending(const void* a, const void* b) {
+    const CostOrder* x = (const CostOrder*)a;
+    const CostOrder* y = (const CostOrder*)b;
+    if (x->cost != y->cost) return x->cost < y->cost ? 1 : -1;
+    return x->index - y->index;
+}
+
+// ============================================================================
+// LANE MANAGEMENT
+// ============================================================================
+
+static void compute_patient_constants(PatientConstants* k, const PopulationSoA* pop,
+                                      int i, float dt, int days) {
+    float cl_factor = clearance_factor_from_covariates(pop->age[i], pop->renal_function[i],
+                                                       pop->hepatic_function[i],
+                                                       pop->cyp2d6_phenotype[i], pop->weight[i]);
+
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        PkCoefficients pk;
+        pk_coefficients_init(&pk, pk_compound_profile(c), cl_factor, dt);
+        k->decay_e[c] = pk.decay_e;
+        k->decay_a[c] = pk.decay_a;
+        k->transfer[c] = pk.transfer;
+        k->to_gut[c] = pk.to_gut;
+        k->to_central[c] = pk.to_central;
+        k->from_peripheral[c] = pk.from_peripheral;
+        k->to_peripheral[c] = pk.to_peripheral;
+        k->decay_p[c] = pk.decay_p;
+        k->transfer_p[c] = pk.transfer_p;
+        k->dose_scale[c] = 1.0f;
+
+        pk_coefficients_init_formulation(&pk, pk_compound_profile(c), cl_factor, dt,
+                                         PK_SUSTAINED_RELEASE, 1.0f);
+        k->sr_decay_a[c] = pk.decay_a;
+        k->sr_transfer[c] = pk.transfer;
+        k->sr_transfer_p[c] = pk.transfer_p;
+    }
+
+    // Dose reduction for elderly or impaired
+    if (pop->age[i] > 70 || pop->renal_function[i] < 30) {
+        k->dose_scale[PK_DPP26] = 0.75f;
+    }
+
+    // Genetic modulation of analgesia
+    float gain = 1.0f;
+    if (pop->oprm1_variant[i]) gain *= 0.8f;
+    if (pop->comt_variant[i]) gain *= 1.1f;
+    k->analgesia_gain = gain;
+
+    k->baseline_pain = pop->baseline_pain_score[i];
+    k->adherence = pop->adherence_probability[i];
+    k->predicted_days = predicted_treatment_days(k->adherence, days);
+    k->patient_id = pop->patient_id[i];
+}
+
+// Switches lane l to the doses of a titration phase
+static void load_lane_phase(LaneState* s, int l, const DoseEventTable* events, int phase) {
+    s->phase[l] = phase;
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        for (int e = 0; e < events->n_events[c]; e++) {
+            s->event_dose[c][e][l] = events->dose_mg[phase][c][e] * s->pk_dose_scale[c][l];
+        }
+    }
+}
+
+// Puts patient i (constants k) on lane l, or masks the lane if k is NULL.
+// stream_index selects the protocol's random streams (see rng_protocol_stream).
+static void load_lane(LaneState* s, int l, const PatientConstants* k, int i,
+                      const DoseEventTable* events, int stream_index) {
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        s->pk_gut[c][l] = 0;
+        s->pk_central[c][l] = 0;
+        s->pk_peripheral[c][l] = 0;
+        s->pk_depot[c][l] = 0;
+        s->pk_release_rate[c][l] = 0;
+    }
+    s->tolerance[l] = 0;
+    s->cumulative_analgesia[l] = 0;
+    s->max_beta_arrestin[l] = 0;
+    s->total_cost[l] = 0;
+    s->trial_pain_sum[l] = 0;
+    s->adverse_events[l] = 0;
+    s->withdrawal[l] = (WithdrawalEpisode){0};
+    s->day[l] = 0;
+    s->patient[l] = i;
+
+    if (!k) {
+        // Masked lane: benign values so the vector math stays finite
+        s->active[l] = 0.0f;
+        for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+            s->pk_decay_e[c][l] = 0;
+            s->pk_decay_a[c][l] = 0;
+            s->pk_transfer[c][l] = 0;
+            s->pk_dose_scale[c][l] = 0;
+            s->pk_to_gut[c][l] = 0;
+            s->pk_to_central[c][l] = 0;
+            s->pk_from_peripheral[c][l] = 0;
+            s->pk_to_peripheral[c][l] = 0;
+            s->pk_decay_p[c][l] = 0;
+            s->pk_transfer_p[c][l] = 0;
+            s->pk_to_depot[c][l] = 0;
+            s->pk_release_per_mg[c][l] = 0;
+        }
+        s->baseline_pain[l] = 0;
+        s->analgesia_gain[l] = 0;
+        s->adherence[l] = 1.0f;
+        s->ae_countdown[l] = INT_MAX;
+        load_lane_phase(s, l, events, 0);
+        return;
+    }
+
+    s->active[l] = 1.0f;
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        int sustained = events->formulation[c] == PK_SUSTAINED_RELEASE;
+        int zero_order = events->formulation[c] == PK_ZERO_ORDER_RELEASE;
+        s->pk_decay_e[c][l] = k->decay_e[c];
+        s->pk_decay_a[c][l] = sustained ? k->sr_decay_a[c] : k->decay_a[c];
+        s->pk_transfer[c][l] = sustained ? k->sr_transfer[c] : k->transfer[c];
+        s->pk_dose_scale[c][l] = k->dose_scale[c];
+        s->pk_to_gut[c][l] = zero_order ? 0 : k->to_gut[c];
+        s->pk_to_central[c][l] = k->to_central[c];
+        s->pk_from_peripheral[c][l] = k->from_peripheral[c];
+        s->pk_to_peripheral[c][l] = k->to_peripheral[c];
+        s->pk_decay_p[c][l] = k->decay_p[c];
+        s->pk_transfer_p[c][l] = sustained ? k->sr_transfer_p[c] : k->transfer_p[c];
+        s->pk_to_depot[c][l] = zero_order ? k->to_gut[c] : 0;
+        s->pk_release_per_mg[c][l] = zero_order ? k->to_gut[c] / events->release_steps[c] : 0;
+    }
+    load_lane_phase(s, l, events, events->phase_of_day[0]);
+
+    s->analgesia_gain[l] = k->analgesia_gain;
+    s->baseline_pain[l] = k->baseline_pain;
+    s->adherence[l] = k->adherence;
+
+    // Stream index 0 uses the same (seed, patient, stream) keys as the scalar kernel
+    rng_stream_init(&s->ae_rng[l], rng_get_seed(), k->patient_id,
+                    rng_protocol_stream(RNG_STREAM_ADVERSE_EVENTS, stream_index));
+    rng_stream_init(&s->adherence_rng[l], rng_get_seed(), k->patient_id,
+                    rng_protocol_stream(RNG_STREAM_ADHERENCE, stream_index));
+    s->ae_countdown[l] = rng_thinning_gap(&s->ae_rng[l], &s->ae_thinning);
+}
+
+static int any_lane_active(const LaneState* s) {
+    for (int l = 0; l < SIM_LANES; l++) {
+        if (s->active[l] != 0.0f) return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// BATCH KERNEL
+// ============================================================================
+
+// Kernel variants: optional PK state the loop carries, plus the tolerance
+// model in the bits from KERNEL_TOLERANCE_SHIFT
+#define KERNEL_ZERO_ORDER 1       // Release depot (a zero-order compound)
+#define KERNEL_TWO_COMPARTMENT 2  // Peripheral compartment
+#define KERNEL_TOLERANCE_SHIFT 2
+#define KERNEL_VARIANTS (TOLERANCE_N_MODELS << KERNEL_TOLERANCE_SHIFT)
+
+// Runs patients [first, last) under the dose events of one protocol; k holds their constants
+// and lanes take patients first + order[0], first + order[1], ...
+// Finished records also go to block_records[i - first] when it is non-NULL.
+// variant is a combination of the KERNEL_* values above and matches
+// tolerance->kind. Always inlined into the grid instances.
+static inline __attribute__((always_inline))
+void run_block_grid(const PatientConstants* k, const int* order, int first, int last,
+                    const DoseEventTable* events, const ToleranceModel* tolerance,
+                    int stream_index, const OutcomeSink* sink, OutcomeStats* stats,
+                    CompactOutcome* block_records, const int days,
+                    const int timesteps_per_day, const int variant) {
+    const int zero_order = variant & KERNEL_ZERO_ORDER;
+    const int two_compartment = variant & KERNEL_TWO_COMPARTMENT;
+    const ToleranceKind tolerance_kind = (ToleranceKind)(variant >> KERNEL_TOLERANCE_SHIFT);
+    const ToleranceModel tolerance_model = *tolerance;
+    const WithdrawalConfig* withdrawal = withdrawal_config();
+    LaneState s;
+    rng_thinning_init(&s.ae_thinning, adverse_event_probability_bound());
+    int next = 0;
+    for (int l = 0; l < SIM_LANES; l++) {
+        int i = first + next < last ? first + order[next++] : -1;
+        load_lane(&s, l, i >= 0 ? &k[i - first] : NULL, i, events, stream_index);
+    }
+
+    while (any_lane_active(&s)) {
+        float daily_pain[SIM_LANES] LANE_ALIGN = {0};
+        float daily_analgesia[SIM_LANES] LANE_ALIGN = {0};
+        float ae_probability[SIM_LANES] LANE_ALIGN;
+        int next_event[PK_N_COMPOUNDS] = {0};
+
+        for (int ts = 0; ts < timesteps_per_day; ts++) {
+            // Lanes are aligned on day boundaries, so the dose timesteps of
+            // the day are shared by every lane; the amounts follow each
+            // lane's titration phase
+            int due[PK_N_COMPOUNDS], event[PK_N_COMPOUNDS];
+            for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+                int e = next_event[c];
+                due[c] = e < events->n_events[c] && events->step[c][e] == ts;
+                event[c] = due[c] ? e : 0;
+                next_event[c] += due[c];
+            }
+
+            #pragma omp simd
+            for (int l = 0; l < SIM_LANES; l++) {
+                float conc[PK_N_COMPOUNDS];
+                for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+                    float dose = due[c] ? s.event_dose[c][event[c]][l] : 0.0f;
+                    float gut = s.pk_gut[c][l] + dose * s.pk_to_gut[c][l];
+                    float central = s.pk_central[c][l] + dose * s.pk_to_central[c][l];
+                    if (zero_order) {
+                        // A new dose restarts the release at its own rate
+                        float depot = s.pk_depot[c][l] + dose * s.pk_to_depot[c][l];
+                        float rate = dose > 0 ? dose * s.pk_release_per_mg[c][l]
+                                              : s.pk_release_rate[c][l];
+                        float released = pk_release_step(depot, rate);
+                        s.pk_depot[c][l] = depot - released;
+                        s.pk_release_rate[c][l] = rate;
+                        gut += released;
+                    }
+                    conc[c] = central;
+                    if (two_compartment) {
+                        float peripheral = s.pk_peripheral[c][l];
+                        s.pk_central[c][l] = pk_step_central2(central, peripheral, gut,
+                                                              s.pk_decay_e[c][l],
+                                                              s.pk_from_peripheral[c][l],
+                                                              s.pk_transfer[c][l]);
+                        s.pk_peripheral[c][l] = pk_step_peripheral(central, peripheral, gut,
+                                                                   s.pk_to_peripheral[c][l],
+                                                                   s.pk_decay_p[c][l],
+                                                                   s.pk_transfer_p[c][l]);
+                    } else {
+                        s.pk_central[c][l] = pk_step_central(central, gut, s.pk_decay_e[c][l],
+                                                             s.pk_transfer[c][l]);
+                    }
+                    s.pk_gut[c][l] = gut * s.pk_decay_a[c][l];
+                }
+
+                ReceptorState receptor = calculate_receptor_dynamics(conc[PK_SR17018],
+                                                                     conc[PK_SR14968],
+                                                                     conc[PK_DPP26],
+                                                                     s.tolerance[l],
+                                                                     tolerance_kind,
+                                                                     &tolerance_model);
+                int live = s.active[l] != 0.0f;
+                s.tolerance[l] = live ? receptor.tolerance_level : s.tolerance[l];
+                s.max_beta_arrestin[l] = live ? sim_maxf(s.max_beta_arrestin[l], receptor.beta_arrestin_signal)
+                                              : s.max_beta_arrestin[l];
+
+                float analgesia = receptor.mu_receptor_activity * s.analgesia_gain[l];
+                float pain = clamp(s.baseline_pain[l] * (1 - analgesia * 0.7f), 0, 10);
+
+                daily_pain[l] += pain;
+                daily_analgesia[l] += analgesia;
+                s.cumulative_analgesia[l] += analgesia * s.active[l];
+                ae_probability[l] = adverse_event_probability(receptor.beta_arrestin_signal);
+            }
+
+            // Adverse events: RNG draws stay scalar and only happen at a
+            // lane's thinning candidates; masked lanes never reach one
+            for (int l = 0; l < SIM_LANES; l++) {
+                if (--s.ae_countdown[l] == 0) {
+                    s.adverse_events[l] += rng_thinning_accept(&s.ae_rng[l], &s.ae_thinning,
+                                                               ae_probability[l]);
+                    s.ae_countdown[l] = rng_thinning_gap(&s.ae_rng[l], &s.ae_thinning);
+                }
+            }
+        }
+
+        // Day boundary: record, run discontinuation checks, refill lanes
+        for (int l = 0; l < SIM_LANES; l++) {
+            if (s.active[l] == 0.0f) continue;
+
+            int day = s.day[l];
+            float day_pain = daily_pain[l] / timesteps_per_day;
+            s.trace_pain[l][day] = day_pain;
+            s.trace_analgesia[l][day] = daily_analgesia[l] / timesteps_per_day;
+            s.total_cost[l] += COST_PER_DAY_DPP26;
+            if (day < TRIAL_PERIOD_DAYS) s.trial_pain_sum[l] += day_pain;
+
+            DiscontinuationReason reason = REASON_COMPLETED;
+            if (day_pain > PAIN_CONTROL_FAILURE) {
+                reason = REASON_INADEQUATE_ANALGESIA;
+            } else if (rng_uniform(&s.adherence_rng[l]) > s.adherence[l]) {
+                reason = REASON_NON_ADHERENCE;
+            } else if (day == TRIAL_PERIOD_DAYS &&
+                       s.trial_pain_sum[l] / TRIAL_PERIOD_DAYS > 5.0f) {
+                reason = REASON_TRIAL_FAILURE;
+            }
+
+            if (reason == REASON_COMPLETED && day + 1 < days) {
+                if (withdrawal->enabled) {
+                    withdrawal_day_boundary(withdrawal, &s.withdrawal[l], s.pk_central[PK_DPP26][l],
+                                            s.pk_central[PK_SR17018][l], s.tolerance[l]);
+                }
+                s.day[l]++;
+                int phase = events->phase_of_day[day + 1];
+                if (phase != s.phase[l]) load_lane_phase(&s, l, events, phase);
+                continue;
+            }
+
+            if (withdrawal->enabled) {
+                withdrawal_end_of_treatment(withdrawal, &s.withdrawal[l],
+                                            s.pk_central[PK_SR17018][l], s.tolerance[l]);
+            }
+
+            int i = s.patient[l];
+            CompactOutcome record;
+            outcome_record_finalize(&record, k[i - first].patient_id, reason,
+                                    reason == REASON_COMPLETED ? 0 : day,
+                                    s.cumulative_analgesia[l], s.tolerance[l],
+                                    s.max_beta_arrestin[l], s.adverse_events[l], s.total_cost[l],
+                                    s.withdrawal[l].occurred);
+            outcome_sink_emit(sink, stats, i, &record, s.trace_pain[l], s.trace_analgesia[l]);
+            if (block_records) block_records[i - first] = record;
+
+            i = first + next < last ? first + order[next++] : -1;
+            load_lane(&s, l, i >= 0 ? &k[i - first] : NULL, i, events, stream_index);
+        }
+    }
+}
+
+typedef void (*RunBlockFn)(const PatientConstants* k, const int* order, int first, int last,
+                           const DoseEventTable* events, const ToleranceModel* tolerance,
+                           int stream_index, const OutcomeSink* sink, OutcomeStats* stats,
+                           CompactOutcome* block_records, int days, int timesteps_per_day);
+
+// One instance per common timestep count (hourly, the default, 2-hourly,
+// 30 and 15 minutes) and variant. The timesteps_per_day argument is
+// ignored in favour of the constant, except by the generic instances.
+#define RUN_BLOCK_INSTANCE(name, steps, variant)                                          \
+    static void name(const PatientConstants* k, const int* order, int first,              \
+                     int last, const DoseEventTable* events,                              \
+                     const ToleranceModel* tolerance, int stream_index,                   \
+                     const OutcomeSink* sink, OutcomeStats* stats,                        \
+                     CompactOutcome* block_records, int days, int timesteps_per_day) {    \
+        (void)timesteps_per_day;                                                          \
+        run_block_grid(k, order, first, last, events, tolerance, stream_index, sink,      \
+                       stats, block_records, days, steps, variant);                       \
+    }
+
+#define RUN_BLOCK_PK_VARIANTS(grid, steps, tol)                                           \
+    RUN_BLOCK_INSTANCE(run_block_##grid##_##tol##_0, steps, (tol << KERNEL_TOLERANCE_SHIFT) | 0) \
+    RUN_BLOCK_INSTANCE(run_block_##grid##_##tol##_1, steps, (tol << KERNEL_TOLERANCE_SHIFT) | 1) \
+    RUN_BLOCK_INSTANCE(run_block_##grid##_##tol##_2, steps, (tol << KERNEL_TOLERANCE_SHIFT) | 2) \
+    RUN_BLOCK_INSTANCE(run_block_##grid##_##tol##_3, steps, (tol << KERNEL_TOLERANCE_SHIFT) | 3)
+
+// Tolerance models in ToleranceKind order
+#define RUN_BLOCK_GRID(grid, steps)       \
+    RUN_BLOCK_PK_VARIANTS(grid, steps, 0) \
+    RUN_BLOCK_PK_VARIANTS(grid, steps, 1) \
+    RUN_BLOCK_PK_VARIANTS(grid, steps, 2)
+
+#define RUN_BLOCK_PK_ROW(grid, tol)                                                 \
+    run_block_##grid##_##tol##_0, run_block_##grid##_##tol##_1,                     \
+    run_block_##grid##_##tol##_2, run_block_##grid##_##tol##_3
+
+#define RUN_BLOCK_ROW(grid) \
+    {RUN_BLOCK_PK_ROW(grid, 0), RUN_BLOCK_PK_ROW(grid, 1), RUN_BLOCK_PK_ROW(grid, 2)}
+
+RUN_BLOCK_GRID(12, 12)
+RUN_BLOCK_GRID(24, 24)
+RUN_BLOCK_GRID(48, 48)
+RUN_BLOCK_GRID(96, 96)
+RUN_BLOCK_GRID(generic, timesteps_per_day)
+
+static RunBlockFn run_block_for_grid(int timesteps_per_day, int variant) {
+    static const RunBlockFn instances[][KERNEL_VARIANTS] = {
+        RUN_BLOCK_ROW(12), RUN_BLOCK_ROW(24), RUN_BLOCK_ROW(48), RUN_BLOCK_ROW(96),
+        RUN_BLOCK_ROW(generic)
+    };
+    switch (timesteps_per_day) {
+        case 12: return instances[0][variant];
+        case 24: return instances[1][variant];
+        case 48: return instances[2][variant];
+        case 96: return instances[3][variant];
+        default: return instances[4][variant];
+    }
+}
+
+void simulate_patient_batch(const PopulationSoA* pop, const DoseSchedule* schedule,
+                            int first, int last, const OutcomeSink* sink,
+                            OutcomeStats* stats) {
+    simulate_patient_batch_sweep(pop, schedule, 1, first, last, sink, stats, NULL);
+}
+
+void simulate_patient_batch_sweep(const PopulationSoA* pop, const DoseSchedule* schedules,
+                                  int n_protocols, int first, int last,
+                                  const OutcomeSink* sinks, OutcomeStats* stats,
+                                  PairedStats* paired) {
+    const int days = sim_days();
+    const int timesteps_per_day = sim_timesteps_per_day();
+    const float dt = 24.0f / timesteps_per_day;
+    ToleranceModel tolerance;
+    tolerance_model_init(&tolerance, tolerance_config(), dt / 24.0f);
+    const int model_variant = (pk_model() == PK_TWO_COMPARTMENT ? KERNEL_TWO_COMPARTMENT : 0) |
+                              tolerance.kind << KERNEL_TOLERANCE_SHIFT;
+
+    DoseEventTable* events = (DoseEventTable*)malloc(n_protocols * sizeof(DoseEventTable));
+    if (!events) {
+        fprintf(stderr, "Failed to allocate dose event tables\n");
+        exit(1);
+    }
+    for (int p = 0; p < n_protocols; p++) {
+        if (dose_events_compile(&events[p], &schedules[p], timesteps_per_day) != 0) {
+            fprintf(stderr, "Error: dose schedule %d needs more than %d dose timesteps per day\n",
+                    p, DOSE_MAX_EVENTS);
+            exit(1);
+        }
+    }
+
+    // Paired mode keeps each protocol's block of records until the block
+    // is done, then differences them patient by patient
+    CompactOutcome* records = NULL;
+    if (paired) {
+        records = (CompactOutcome*)malloc((size_t)n_protocols * BATCH_KERNEL_BLOCK *
+                                          sizeof(CompactOutcome));
+        if (!records) {
+            fprintf(stderr, "Failed to allocate paired comparison buffer\n");
+            exit(1);
+        }
+    }
+
+    PatientConstants k[BATCH_KERNEL_BLOCK];
+    CostOrder by_cost[BATCH_KERNEL_BLOCK];
+    int order[BATCH_KERNEL_BLOCK];
+    for (int start = first; start < last; start += BATCH_KERNEL_BLOCK) {
+        int end = start + BATCH_KERNEL_BLOCK < last ? start + BATCH_KERNEL_BLOCK : last;
+        for (int i = start; i < end; i++) {
+            compute_patient_constants(&k[i - start], pop, i, dt, days);
+            by_cost[i - start] = (CostOrder){k[i - start].predicted_days, i - start};
+        }
+
+        // Longest patients take the lanes first
+        qsort(by_cost, end - start, sizeof(CostOrder), compare_cost_descending);
+        for (int j = 0; j < end - start; j++) order[j] = by_cost[j].index;
+
+        // Every protocol reuses the block's constants while they are in cache
+        for (int p = 0; p < n_protocols; p++) {
+            int variant = model_variant | (events[p].zero_order ? KERNEL_ZERO_ORDER : 0);
+            RunBlockFn run_block = run_block_for_grid(timesteps_per_day, variant);
+            run_block(k, order, start, end, &events[p], &tolerance, paired ? 0 : p, &sinks[p],
+                      stats ? &stats[p] : NULL,
+                      records ? &records[(size_t)p * BATCH_KERNEL_BLOCK] : NULL,
+                      days, timesteps_per_day);
+        }
+
+        if (paired) {
+            for (int p = 1; p < n_protocols; p++) {
+                const CompactOutcome* candidate = &records[(size_t)p * BATCH_KERNEL_BLOCK];
+                for (int j = 0; j < end - start; j++) {
+                    paired_stats_add(&paired[p], &records[j], &candidate[j],
+                                     pop->sample_weight[start + j]);
+                }
+            }
+        }
+    }
+
+    free(records);
+    free(events);
+}
+
+// ============================================================================
+// PARALLEL DRIVER
+// ============================================================================
+
+// Patients [first, last) under every protocol; report starts the progress line
+static void run_population_range(const PopulationSoA* pop, const DoseSchedule* schedules,
+                                 int n_protocols, int first, int last,
+                                 const OutcomeSink* sinks, PairedStats* paired, int report) {
+    int n_blocks = (last - first + BATCH_KERNEL_BLOCK - 1) / BATCH_KERNEL_BLOCK;
+    int days = sim_days();
+
+    int keep_stats = 0;
+    for (int p = 0; p < n_protocols; p++) {
+        keep_stats |= sinks[p].stats != NULL;
+    }
+
+    // Blocks in descending predicted cost (longest processing time first)
+    CostOrder* blocks = (CostOrder*)malloc((n_blocks > 0 ? n_blocks : 1) * sizeof(CostOrder));
+    if (!blocks) {
+        fprintf(stderr, "Failed to allocate the block schedule\n");
+        exit(1);
+    }
+    #pragma omp parallel for schedule(static)
+    for (int b = 0; b < n_blocks; b++) {
+        int block_first = first + b * BATCH_KERNEL_BLOCK;
+        int block_last = block_first + BATCH_KERNEL_BLOCK < last ? block_first + BATCH_KERNEL_BLOCK : last;
+        float cost = 0;
+        for (int i = block_first; i < block_last; i++) {
+            cost += predicted_treatment_days(pop->adherence_probability[i], days);
+        }
+        blocks[b] = (CostOrder){cost, b};
+    }
+    qsort(blocks, n_blocks, sizeof(CostOrder), compare_cost_descending);
+
+    progress_start((long)(last - first) * n_protocols, report);
+
+    #pragma omp parallel
+    {
+        OutcomeStats* local = NULL;
+        if (keep_stats) {
+            local = (OutcomeStats*)malloc(n_protocols * sizeof(OutcomeStats));
+            if (!local) {
+                fprintf(stderr, "Failed to allocate sweep accumulators\n");
+                exit(1);
+            }
+            for (int p = 0; p < n_protocols; p++) outcome_stats_init(&local[p]);
+        }
+
+        PairedStats* local_paired = NULL;
+        if (paired) {
+            local_paired = (PairedStats*)malloc(n_protocols * sizeof(PairedStats));
+            if (!local_paired) {
+                fprintf(stderr, "Failed to allocate sweep accumulators\n");
+                exit(1);
+            }
+            for (int p = 0; p < n_protocols; p++) paired_stats_init(&local_paired[p]);
+        }
+
+        #pragma omp for schedule(dynamic, 1) nowait
+        for (int b = 0; b < n_blocks; b++) {
+            double started = omp_get_wtime();
+            int block_first = first + blocks[b].index * BATCH_KERNEL_BLOCK;
+            int block_last = block_first + BATCH_KERNEL_BLOCK < last ? block_first + BATCH_KERNEL_BLOCK : last;
+            simulate_patient_batch_sweep(pop, schedules, n_protocols, block_first, block_last,
+                                         sinks, local, local_paired);
+            progress_add((long)(block_last - block_first) * n_protocols);
+            progress_add_busy(omp_get_wtime() - started);
+        }
+
+        if (keep_stats) {
+            #pragma omp critical
+            for (int p = 0; p < n_protocols; p++) {
+                if (sinks[p].stats) outcome_stats_merge(sinks[p].stats, &local[p]);
+            }
+            free(local);
+        }
+
+        if (paired) {
+            #pragma omp critical
+            for (int p = 1; p < n_protocols; p++) {
+                paired_stats_merge(&paired[p], &local_paired[p]);
+            }
+            free(local_paired);
+        }
+    }
+
+    progress_stop();
+    free(blocks);
+}
+
+void simulate_population_batched(const PopulationSoA* pop, const DoseSchedule* schedule,
+                                 const OutcomeSink* sink) {
+    run_population_range(pop, schedule, 1, 0, pop->n, sink, NULL, 1);
+}
+
+void simulate_population_range(const PopulationSoA* pop, const DoseSchedule* schedule,
+                               int first, int last, const OutcomeSink* sink) {
+    run_population_range(pop, schedule, 1, first, last, sink, NULL, 0);
+}
+
+void simulate_population_sweep(const PopulationSoA* pop, const DoseSchedule* schedules,
+                               int n_protocols, const OutcomeSink* sinks, PairedStats* paired) {
+    run_population_range(pop, schedules, n_protocols, 0, pop->n, sinks, paired, 1);
+}
@@ -0,0 +1,73 @@
+/*
+ * batch_kernel.h - SIMD batch treatment kernel
+ *
+ * Advances SIM_LANES patients in lockstep through the same day/timestep
+ * grid as simulate_patient_treatment(): PK, receptor dynamics, pain score
+ * and the daily discontinuation checks.
+ *
+ * Agreement with the scalar kernel (-DSCALAR_KERNEL):
+ *   - Deterministic trajectories (daily pain, analgesia, tolerance) match
+ *     to within 1e-4 relative, or 1e-6 absolute for pain scores near zero
+ *     where 1 - 0.7*analgesia cancels. Differences come only from FMA
+ *     contraction and evaluation order in the vectorized lane loop.
+ *   - Random draws come from the same per-patient counter-based streams
+ *     (sim_rng.h), so stochastic fields are identical unless a draw falls
+ *     within rounding distance of its threshold.
+ */
+
+#ifndef BATCH_KERNEL_H
+#define BATCH_KERNEL_H
+
+#include "patient_sim.h"
+#include "population_soa.h"
+#include "outcome_record.h"
+#include "outcome_stats.h"
+#include "dose_schedule.h"
+
+#if defined(__AVX512F__)
+#define SIM_LANES 16
+#else
+#define SIM_LANES 8
+#endif
+
+// Patients per scheduling block; lanes are refilled from within the block
+#define BATCH_KERNEL_BLOCK 256
+
+// Simulates patients [first, last) of pop, delivering each finished patient
+// to sink and to stats (the calling thread's accumulator, may be NULL)
+void simulate_patient_batch(const PopulationSoA* pop, const DoseSchedule* schedule,
+                            int first, int last, const OutcomeSink* sink,
+                            OutcomeStats* stats);
+
+// sink->stats receives the merged per-thread accumulators
+void simulate_population_batched(const PopulationSoA* pop, const DoseSchedule* schedule,
+                                 const OutcomeSink* sink);
+
+// Patients [first, last) only, without a progress line; sink->stats keeps
+// accumulating across calls
+void simulate_population_range(const PopulationSoA* pop, const DoseSchedule* schedule,
+                               int first, int last, const OutcomeSink* sink);
+
+/*
+ * Sweep mode: every patient is simulated under each of n_protocols
+ * dosing schedules. The dose-independent per-patient constants (clearance, PK
+ * decay factors, genetic gain) are computed once per block and reused for
+ * every protocol while still in cache. Protocol p delivers to sinks[p]
+ * (and stats[p]); protocol 0 matches a single-protocol run.
+ *
+ * With paired == NULL each protocol draws from its own adverse-event and
+ * adherence streams, so protocols are statistically independent.
+ * Otherwise every protocol replays protocol 0's streams (common random
+ * numbers) and paired[p], p >= 1, accumulates the per-patient differences
+ * between protocol p and protocol 0. The caller initializes paired[];
+ * paired[0] is left untouched.
+ */
+void simulate_patient_batch_sweep(const PopulationSoA* pop, const DoseSchedule* schedules,
+                                  int n_protocols, int first, int last,
+                                  const OutcomeSink* sinks, OutcomeStats* stats,
+                                  PairedStats* paired);
+
+void simulate_population_sweep(const PopulationSoA* pop, const DoseSchedule* schedules,
+                               int n_protocols, const OutcomeSink* sinks, PairedStats* paired);
+
+#endif // BATCH_KERNEL_H
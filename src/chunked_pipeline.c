@@ -0,0 +1,81 @@
+/*
+ * chunked_pipeline.c - Bounded-memory generate -> simulate -> reduce runs
+ */
+
+#include "chunked_pipeline.h"
+#include "batch_kernel.h"
+#include <pthread.h>
+
+typedef struct {
+    PopulationSoA* chunk;
+    int first, last;
+    const SamplingPlan* plan;
+    int threads;  // Team size of the producer's parallel regions
+} ChunkJob;
+
+static void* produce_chunk(void* arg) {
+    const ChunkJob* job = (const ChunkJob*)arg;
+    // A thread outside the OpenMP team keeps its own thread count, so this
+    // only sizes the producer's generation team
+    omp_set_num_threads(job->threads);
+    generate_population_chunk(job->chunk, job->first, job->last, job->plan);
+    return NULL;
+}
+
+int simulate_population_chunked(int n, int chunk_patients, const SamplingPlan* plan,
+                                const DoseSchedule* schedule, const OutcomeSink* sink) {
+    int chunk = chunk_patients < n ? chunk_patients : n;
+    PopulationSoA* buffers[2] = {population_soa_create(chunk), population_soa_create(chunk)};
+    if (!buffers[0] || !buffers[1]) {
+        fprintf(stderr, "Failed to allocate two chunks of %d patients\n", chunk);
+        population_soa_destroy(buffers[0]);
+        population_soa_destroy(buffers[1]);
+        return -1;
+    }
+
+    // The producer takes a share of the threads while a chunk is simulated
+    int threads = omp_get_max_threads();
+    int producer_threads = threads / CHUNK_PRODUCER_THREAD_SHARE > 1
+                               ? threads / CHUNK_PRODUCER_THREAD_SHARE : 1;
+    int simulation_threads = threads > producer_threads ? threads - producer_threads : 1;
+    int weighted = plan && (plan->mode & SAMPLING_STRATIFIED);
+    int n_chunks = (int)(((long)n + chunk - 1) / chunk);
+
+    // Nothing to overlap the first chunk with
+    generate_population_chunk(buffers[0], 0, chunk, plan);
+
+    omp_set_num_threads(simulation_threads);
+    for (int k = 0; k < n_chunks; k++) {
+        PopulationSoA* current = buffers[k % 2];
+        int last = (int)((long)k * chunk + current->n);
+
+        pthread_t producer;
+        int producing = 0;
+        ChunkJob next = {
+            .chunk = buffers[(k + 1) % 2],
+            .first = last,
+            .last = n - last > chunk ? last + chunk : n,
+            .plan = plan,
+            .threads = producer_threads
+        };
+        if (last < n) producing = pthread_create(&producer, NULL, produce_chunk, &next) == 0;
+
+        OutcomeSink chunk_sink = *sink;
+        chunk_sink.weights = weighted ? current->sample_weight : NULL;
+        simulate_population_range(current, schedule, 0, current->n, &chunk_sink);
+
+        if (producing) {
+            pthread_join(producer, NULL);
+        } else if (last < n) {
+            generate_population_chunk(next.chunk, next.first, next.last, plan);
+        }
+        printf("\r  Chunk %d/%d: %d patients", k + 1, n_chunks, last);
+        fflush(stdout);
+    }
+    printf("\n");
+    omp_set_num_threads(threads);
+
+    population_soa_destroy(buffers[0]);
+    population_soa_destroy(buffers[1]);
+    return 0;
+}
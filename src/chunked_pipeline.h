@@ -0,0 +1,42 @@
+/*
+ * chunked_pipeline.h - Bounded-memory generate -> simulate -> reduce runs
+ *
+ * The phased run holds the whole population and one outcome per patient,
+ * so its memory grows with the population size. A chunked run streams the
+ * population instead: patients are generated chunk by chunk from the
+ * counter-based seed, simulated, folded into the outcome statistics and
+ * dropped. Two chunk buffers alternate; while the OpenMP team simulates
+ * chunk k, a producer thread generates chunk k + 1 into the other buffer.
+ *
+ * Peak memory is two chunks of population columns plus the per-thread
+ * accumulators, whatever the population size. Patients keep their
+ * population index, and every draw is keyed by it, so each patient's
+ * outcome is the same as in a phased run with the same seed; the summary
+ * statistics only differ in merge-order rounding.
+ */
+
+#ifndef CHUNKED_PIPELINE_H
+#define CHUNKED_PIPELINE_H
+
+#include "patient_sim.h"
+#include "population_gen.h"
+#include "outcome_record.h"
+#include "outcome_stats.h"
+#include "dose_schedule.h"
+
+// While a chunk is simulated, the producer gets one thread per this many
+// (at least one) and the simulation the rest
+#define CHUNK_PRODUCER_THREAD_SHARE 8
+
+/*
+ * Simulates patients [0, n) under schedule in chunks of chunk_patients.
+ * plan may be NULL; stratified plans weight each patient by its sample
+ * weight. sink->stats is required and ends up holding the merged
+ * statistics; per-patient outputs (records, traces, outcomes) must be NULL
+ * because no chunk outlives its simulation. Returns 0, or -1 with a
+ * message if the chunk buffers cannot be allocated.
+ */
+int simulate_population_chunked(int n, int chunk_patients, const SamplingPlan* plan,
+                                const DoseSchedule* schedule, const OutcomeSink* sink);
+
+#endif // CHUNKED_PIPELINE_H
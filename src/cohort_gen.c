@@ -0,0 +1,224 @@
+/*
+ * cohort_gen.c - Native cohort generation for the Python simulator
+ */
+
+#include "cohort_gen.h"
+#include <float.h>
+
+// Age effects on metabolism and conditions (PatientGenerator)
+#define COHORT_ELDERLY_AGE 65
+#define COHORT_ELDERLY_METABOLISM 0.8f
+#define COHORT_YOUNG_AGE 25
+#define COHORT_YOUNG_METABOLISM 1.2f
+#define COHORT_CONDITION_ONSET_AGE 50
+#define COHORT_CONDITION_RISE_PER_YEAR 0.01f
+
+void cohort_spec_init(CohortSpec* spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->sex_ratio_male = 0.5f;
+    spec->age_alpha = 2.0f;
+    spec->age_beta = 3.0f;
+    spec->min_age = 18;
+    spec->max_age = 85;
+    spec->male_weight_mean = 82.0f;
+    spec->male_weight_std = 15.0f;
+    spec->female_weight_mean = 70.0f;
+    spec->female_weight_std = 13.0f;
+    spec->min_weight = 45.0f;
+    spec->max_weight = 120.0f;
+    spec->pain_alpha = 3.0f;
+    spec->pain_beta = 2.0f;
+    spec->sensitivity_mean = 0.0f;
+    spec->sensitivity_sigma = 0.3f;
+    spec->metabolism_sigma = 0.25f;
+}
+
+int cohort_abi_version(void) {
+    return COHORT_ABI_VERSION;
+}
+
+size_t cohort_spec_bytes(void) {
+    return sizeof(CohortSpec);
+}
+
+size_t cohort_columns_bytes(void) {
+    return sizeof(CohortColumns);
+}
+
+static int is_probability(float p) {
+    return p >= 0.0f && p <= 1.0f;
+}
+
+int cohort_spec_validate(const CohortSpec* spec) {
+    const char* error = NULL;
+    if (!is_probability(spec->sex_ratio_male)) {
+        error = "sex_ratio_male must be in [0, 1]";
+    } else if (!(spec->age_alpha > 0 && spec->age_beta > 0) || spec->min_age > spec->max_age) {
+        error = "age needs positive alpha and beta and min_age <= max_age";
+    } else if (!(spec->male_weight_std >= 0 && spec->female_weight_std >= 0) ||
+               !(spec->min_weight <= spec->max_weight)) {
+        error = "weight needs non-negative deviations and min_weight <= max_weight";
+    } else if (!(spec->pain_alpha > 0 && spec->pain_beta > 0)) {
+        error = "pain needs positive alpha and beta";
+    } else if (!(spec->sensitivity_sigma >= 0 && spec->metabolism_sigma >= 0)) {
+        error = "sensitivity and metabolism sigmas must be non-negative";
+    } else if (spec->n_medications < 0 || spec->n_medications > COHORT_MAX_MEDICATIONS) {
+        error = "too many medications";
+    } else if (spec->n_conditions < 0 || spec->n_conditions > COHORT_MAX_CONDITIONS) {
+        error = "too many conditions";
+    }
+    // Prevalences above 1 saturate, as in PatientGenerator
+    for (int m = 0; !error && m < spec->n_medications; m++) {
+        if (!(spec->medications[m].prevalence >= 0)) error = "medication prevalence must be non-negative";
+    }
+    for (int c = 0; !error && c < spec->n_conditions; c++) {
+        if (!(spec->conditions[c].prevalence >= 0)) error = "condition prevalence must be non-negative";
+    }
+
+    if (error) {
+        fprintf(stderr, "Error: invalid cohort spec: %s\n", error);
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// SAMPLERS
+// ============================================================================
+
+typedef struct {
+    RngStream stream;
+    int has_spare;
+    float spare;
+} CohortRng;
+
+static float cohort_normal(CohortRng* r) {
+    if (r->has_spare) {
+        r->has_spare = 0;
+        return r->spare;
+    }
+    float u = rng_uniform(&r->stream);
+    float v = rng_uniform(&r->stream);
+    float mag = sqrtf(-2.0f * logf(u + FLT_MIN));
+    r->has_spare = 1;
+    r->spare = mag * cosf(2.0f * (float)M_PI * v);
+    return mag * sinf(2.0f * (float)M_PI * v);
+}
+
+// Marsaglia-Tsang; shapes below 1 are boosted by U^(1/shape)
+static float cohort_gamma(CohortRng* r, float shape) {
+    float boost = 1.0f;
+    if (shape < 1.0f) {
+        boost = powf(rng_uniform(&r->stream), 1.0f / shape);
+        shape += 1.0f;
+    }
+
+    const float d = shape - 1.0f / 3.0f;
+    const float c = 1.0f / sqrtf(9.0f * d);
+    for (;;) {
+        float x, v;
+        do {
+            x = cohort_normal(r);
+            v = 1.0f + c * x;
+        } while (v <= 0.0f);
+        v = v * v * v;
+
+        float u = rng_uniform(&r->stream);
+        float x2 = x * x;
+        if (u < 1.0f - 0.0331f * x2 * x2 || logf(u) < 0.5f * x2 + d * (1.0f - v + logf(v))) {
+            return d * v * boost;
+        }
+    }
+}
+
+static float cohort_beta(CohortRng* r, float alpha, float beta) {
+    float x = cohort_gamma(r, alpha);
+    float y = cohort_gamma(r, beta);
+    return x / (x + y);
+}
+
+// ============================================================================
+// GENERATION
+// ============================================================================
+
+static void generate_patient(const CohortSpec* spec, uint64_t seed, int patient_id,
+                             int j, const CohortColumns* out) {
+    CohortRng r = {.has_spare = 0};
+    rng_stream_init(&r.stream, seed, (uint32_t)patient_id, RNG_STREAM_POPULATION);
+
+    int age = spec->min_age +
+              (int)(cohort_beta(&r, spec->age_alpha, spec->age_beta) * (float)(spec->max_age - spec->min_age));
+    if (age > spec->max_age) age = spec->max_age;
+
+    int male = rng_uniform(&r.stream) < spec->sex_ratio_male;
+    float weight = male ? spec->male_weight_mean + spec->male_weight_std * cohort_normal(&r)
+                        : spec->female_weight_mean + spec->female_weight_std * cohort_normal(&r);
+    weight = fminf(fmaxf(weight, spec->min_weight), spec->max_weight);
+
+    float metabolism = expf(spec->metabolism_sigma * cohort_normal(&r));
+    if (age > COHORT_ELDERLY_AGE) {
+        metabolism *= COHORT_ELDERLY_METABOLISM;
+    } else if (age < COHORT_YOUNG_AGE) {
+        metabolism *= COHORT_YOUNG_METABOLISM;
+    }
+    float sensitivity = expf(spec->sensitivity_mean + spec->sensitivity_sigma * cohort_normal(&r));
+    float pain = cohort_beta(&r, spec->pain_alpha, spec->pain_beta) * 10.0f;
+
+    uint16_t medications = 0;
+    float metabolism_multiplier = 1.0f, sensitivity_multiplier = 1.0f;
+    float analgesia_bonus = 0.0f, side_effect_bias = 0.0f, tolerance = 0.0f;
+    for (int m = 0; m < spec->n_medications; m++) {
+        const CohortMedication* med = &spec->medications[m];
+        if (rng_uniform(&r.stream) < med->prevalence) {
+            medications |= (uint16_t)(1u << m);
+            metabolism_multiplier *= med->metabolism_multiplier;
+            sensitivity_multiplier *= med->sensitivity_multiplier;
+            analgesia_bonus += med->analgesia_bonus;
+            side_effect_bias += med->side_effect_bias;
+            tolerance += med->baseline_tolerance;
+        }
+    }
+    metabolism *= metabolism_multiplier;
+    sensitivity *= sensitivity_multiplier;
+
+    uint16_t conditions = 0;
+    float age_factor = 1.0f + (float)(age > COHORT_CONDITION_ONSET_AGE ? age - COHORT_CONDITION_ONSET_AGE : 0) *
+                                  COHORT_CONDITION_RISE_PER_YEAR;
+    for (int c = 0; c < spec->n_conditions; c++) {
+        const CohortCondition* condition = &spec->conditions[c];
+        if (rng_uniform(&r.stream) < fminf(1.0f, condition->prevalence * age_factor)) {
+            conditions |= (uint16_t)(1u << c);
+            metabolism *= condition->metabolism_multiplier;
+        }
+    }
+
+    out->patient_id[j] = patient_id;
+    out->age[j] = age;
+    out->weight[j] = weight;
+    out->male[j] = (uint8_t)male;
+    out->metabolism_rate[j] = metabolism;
+    out->sensitivity[j] = sensitivity;
+    out->pain_severity[j] = pain;
+    out->medications[j] = medications;
+    out->conditions[j] = conditions;
+    out->baseline_tolerance[j] = tolerance;
+    out->metabolism_multiplier[j] = metabolism_multiplier;
+    out->sensitivity_multiplier[j] = sensitivity_multiplier;
+    out->analgesia_bonus[j] = analgesia_bonus;
+    out->side_effect_bias[j] = side_effect_bias;
+}
+
+int cohort_generate(const CohortSpec* spec, uint64_t seed, int first, int n,
+                    const CohortColumns* columns) {
+    if (cohort_spec_validate(spec) != 0) return -1;
+    if (first < 0 || n < 0 || (long)first + n > (long)INT32_MAX + 1) {
+        fprintf(stderr, "Error: cohort range [%d, %d + %d) is out of range\n", first, first, n);
+        return -1;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int j = 0; j < n; j++) {
+        generate_patient(spec, seed, first + j, j, columns);
+    }
+    return 0;
+}
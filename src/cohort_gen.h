@@ -0,0 +1,116 @@
+/*
+ * cohort_gen.h - Native cohort generation for the Python simulator
+ *
+ * patient_simulation_100k.py describes a virtual population by a
+ * PatientGenerationConfig (scenarios.py builds one from a CohortSpec
+ * string such as "n=200,age=60±10,renal=0.3") and draws it patient by
+ * patient in Python. This module draws the same PatientProfile covariates
+ * from the same configuration, in C, as columns:
+ *
+ *   age          min + Beta(alpha, beta) * (max - min), truncated
+ *   sex, weight  male with probability sex_ratio_male; normal by sex,
+ *                clipped to [min_weight, max_weight]
+ *   metabolism   lognormal(0, metabolism_sigma), x0.8 over 65, x1.2
+ *                under 25
+ *   sensitivity  lognormal(sensitivity_mean, sensitivity_sigma)
+ *   pain         Beta(pain_alpha, pain_beta) * 10
+ *   medications  each taken with its prevalence; multipliers multiply,
+ *                bonuses and tolerances add, as in PatientGenerator
+ *   conditions   each present with min(1, prevalence * (1 + 1% per year
+ *                over 50)); a condition may scale metabolism (the
+ *                Python generator's liver 0.6 and kidney 0.7)
+ *
+ * Patient i draws from its own Philox stream (seed, i) of
+ * RNG_STREAM_POPULATION, so a cohort is reproducible for a seed and any
+ * range of it can be generated independently and in parallel. The
+ * numbers differ from numpy's, the distributions do not.
+ *
+ * Built as a shared library for native_cohort.py (ctypes):
+ *   gcc -O3 -march=native -fopenmp -shared -fPIC cohort_gen.c sim_rng.c \
+ *       -lm -o libzp_cohort.so
+ * CohortSpec and CohortColumns are mirrored there field for field; bump
+ * COHORT_ABI_VERSION whenever either layout changes.
+ */
+
+#ifndef COHORT_GEN_H
+#define COHORT_GEN_H
+
+#include "patient_sim.h"
+#include "sim_rng.h"
+
+#define COHORT_ABI_VERSION 1
+#define COHORT_MAX_MEDICATIONS 16
+#define COHORT_MAX_CONDITIONS 16
+
+typedef struct {
+    float prevalence;
+    float metabolism_multiplier;
+    float sensitivity_multiplier;
+    float analgesia_bonus;
+    float side_effect_bias;
+    float baseline_tolerance;
+} CohortMedication;
+
+typedef struct {
+    float prevalence;               // Below age 50; rises 1% per year over
+    float metabolism_multiplier;    // Applied when present
+} CohortCondition;
+
+typedef struct {
+    float sex_ratio_male;
+
+    float age_alpha, age_beta;
+    int32_t min_age, max_age;
+
+    float male_weight_mean, male_weight_std;
+    float female_weight_mean, female_weight_std;
+    float min_weight, max_weight;
+
+    float pain_alpha, pain_beta;
+    float sensitivity_mean, sensitivity_sigma;
+    float metabolism_sigma;
+
+    int32_t n_medications;
+    int32_t n_conditions;
+    CohortMedication medications[COHORT_MAX_MEDICATIONS];
+    CohortCondition conditions[COHORT_MAX_CONDITIONS];
+} CohortSpec;
+
+// Caller-owned output columns, indexed from 0 for the first patient generated
+typedef struct {
+    int32_t* patient_id;
+    int32_t* age;
+    float* weight;
+    uint8_t* male;
+    float* metabolism_rate;          // Medication and condition effects included
+    float* sensitivity;              // Medication effects included
+    float* pain_severity;
+    uint16_t* medications;           // Bit m: spec medication m taken
+    uint16_t* conditions;            // Bit c: spec condition c present
+    float* baseline_tolerance;
+    float* metabolism_multiplier;    // Medication effects alone
+    float* sensitivity_multiplier;
+    float* analgesia_bonus;
+    float* side_effect_bias;
+} CohortColumns;
+
+// PatientGenerationConfig defaults: no medications or conditions
+void cohort_spec_init(CohortSpec* spec);
+
+// Layout checks for bindings
+int cohort_abi_version(void);
+size_t cohort_spec_bytes(void);
+size_t cohort_columns_bytes(void);
+
+// Returns 0, or -1 with a message if spec is out of range
+int cohort_spec_validate(const CohortSpec* spec);
+
+/*
+ * Generates patients [first, first + n) of the cohort under seed into
+ * columns[0 .. n). Uses the OpenMP team; results do not depend on its
+ * size. Returns 0, or -1 with a message if spec is invalid.
+ */
+int cohort_generate(const CohortSpec* spec, uint64_t seed, int first, int n,
+                    const CohortColumns* columns);
+
+#endif // COHORT_GEN_H
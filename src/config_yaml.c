@@ -0,0 +1,240 @@
+/*
+ * config_yaml.c - Reader for the YAML subset of protocol_config.c
+ */
+
+#include "config_yaml.h"
+#include <ctype.h>
+
+#define YAML_MAX_DEPTH 16
+
+static int yaml_add(YamlDocument* doc, const char* key, const char* value, int line) {
+    if (doc->n == doc->capacity) {
+        int capacity = doc->capacity ? doc->capacity * 2 : 256;
+        YamlEntry* entries = (YamlEntry*)realloc(doc->entries, capacity * sizeof(YamlEntry));
+        if (!entries) return -1;
+        doc->entries = entries;
+        doc->capacity = capacity;
+    }
+
+    YamlEntry* e = &doc->entries[doc->n++];
+    snprintf(e->key, YAML_KEY_LEN, "%s", key);
+    snprintf(e->value, YAML_VALUE_LEN, "%s", value);
+    e->line = line;
+    e->depth = 0;
+    for (const char* p = key; *p; p++) e->depth += *p == '.';
+    return 0;
+}
+
+// Trims whitespace in place and returns the start of the text
+static char* trim(char* text) {
+    while (isspace((unsigned char)*text)) text++;
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) *--end = '\0';
+    return text;
+}
+
+static char* unquote(char* text) {
+    size_t n = strlen(text);
+    if (n >= 2 && (text[0] == '"' || text[0] == '\'') && text[n - 1] == text[0]) {
+        text[n - 1] = '\0';
+        return text + 1;
+    }
+    return text;
+}
+
+// First `c` outside quotes and brackets at or after text, or NULL
+static char* find_unquoted(char* text, char c) {
+    char quote = 0;
+    int nesting = 0;
+    for (char* p = text; *p; p++) {
+        if (quote) {
+            if (*p == quote) quote = 0;
+        } else if (*p == '"' || *p == '\'') {
+            quote = *p;
+        } else if (*p == '[' || *p == '{') {
+            if (*p == c && nesting == 0) return p;
+            nesting++;
+        } else if (*p == ']' || *p == '}') {
+            nesting--;
+        } else if (*p == c && nesting == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Splits "key: value" at the first unquoted ':' followed by a space or the end
+static int split_key_value(char* text, char** key, char** value) {
+    for (char* colon = find_unquoted(text, ':'); colon; colon = find_unquoted(colon + 1, ':')) {
+        if (colon[1] == '\0' || isspace((unsigned char)colon[1])) {
+            *colon = '\0';
+            *key = unquote(trim(text));
+            *value = trim(colon + 1);
+            return **key ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+static int parse_flow_mapping(YamlDocument* doc, const char* parent, char* body, int line) {
+    char* item = body;
+    while (item && *trim(item)) {
+        char* comma = find_unquoted(item, ',');
+        if (comma) *comma = '\0';
+
+        char *key, *value;
+        if (split_key_value(item, &key, &value) != 0 || *value == '{' || *value == '[') return -1;
+
+        char path[YAML_KEY_LEN];
+        if (snprintf(path, sizeof(path), "%s.%s", parent, key) >= (int)sizeof(path) ||
+            yaml_add(doc, path, unquote(value), line) != 0) {
+            return -1;
+        }
+        item = comma ? comma + 1 : NULL;
+    }
+    return 0;
+}
+
+int yaml_load(YamlDocument* doc, const char* path) {
+    memset(doc, 0, sizeof(*doc));
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open protocol file %s\n", path);
+        return -1;
+    }
+
+    int indent[YAML_MAX_DEPTH];
+    char parent[YAML_MAX_DEPTH][YAML_KEY_LEN];
+    int depth = 0;
+
+    char buffer[1024];
+    int line_no = 0;
+    const char* error = NULL;
+    while (!error && fgets(buffer, sizeof(buffer), f)) {
+        line_no++;
+        char* comment = find_unquoted(buffer, '#');
+        if (comment) *comment = '\0';
+
+        int spaces = 0;
+        while (buffer[spaces] == ' ') spaces++;
+        char* text = trim(buffer);
+        if (!*text) continue;
+        if (buffer[spaces] == '\t') {
+            error = "tabs are not allowed for indentation";
+            break;
+        }
+        if (text[0] == '-') {
+            error = "block sequences are not supported";
+            break;
+        }
+
+        char *key, *value;
+        if (split_key_value(text, &key, &value) != 0) {
+            error = "expected \"key: value\"";
+            break;
+        }
+
+        while (depth > 0 && indent[depth - 1] >= spaces) depth--;
+        char full[YAML_KEY_LEN];
+        int length = depth > 0 ? snprintf(full, sizeof(full), "%s.%s", parent[depth - 1], key)
+                               : snprintf(full, sizeof(full), "%s", key);
+        if (length >= (int)sizeof(full)) {
+            error = "key path too long";
+            break;
+        }
+
+        if (*value == '{') {
+            size_t n = strlen(value);
+            if (value[n - 1] != '}') {
+                error = "flow mappings must close on the same line";
+                break;
+            }
+            value[n - 1] = '\0';
+            if (yaml_add(doc, full, "", line_no) != 0 ||
+                parse_flow_mapping(doc, full, value + 1, line_no) != 0) {
+                error = "bad flow mapping";
+            }
+            continue;
+        }
+        if (*value == '&' || *value == '*' || *value == '|' || *value == '>') {
+            error = "anchors, aliases and block scalars are not supported";
+            break;
+        }
+
+        if (yaml_add(doc, full, unquote(value), line_no) != 0) {
+            error = "out of memory";
+            break;
+        }
+        if (!*value) {
+            if (depth == YAML_MAX_DEPTH) {
+                error = "nesting too deep";
+                break;
+            }
+            indent[depth] = spaces;
+            snprintf(parent[depth], YAML_KEY_LEN, "%s", full);
+            depth++;
+        }
+    }
+    fclose(f);
+
+    if (error) {
+        fprintf(stderr, "Error: %s:%d: %s\n", path, line_no, error);
+        yaml_free(doc);
+        return -1;
+    }
+    return 0;
+}
+
+void yaml_free(YamlDocument* doc) {
+    free(doc->entries);
+    memset(doc, 0, sizeof(*doc));
+}
+
+const YamlEntry* yaml_find(const YamlDocument* doc, const char* key) {
+    for (int i = 0; i < doc->n; i++) {
+        if (strcmp(doc->entries[i].key, key) == 0) return &doc->entries[i];
+    }
+    return NULL;
+}
+
+const char* yaml_child_value(const YamlDocument* doc, const char* parent, const char* child) {
+    char key[YAML_KEY_LEN];
+    snprintf(key, sizeof(key), "%s.%s", parent, child);
+    const YamlEntry* e = yaml_find(doc, key);
+    return e ? e->value : NULL;
+}
+
+int yaml_parse_floats(const char* value, float* out, int max) {
+    const char* p = value;
+    int bracketed = *p == '[';
+    if (bracketed) p++;
+
+    int n = 0;
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        if (bracketed && *p == ']' && n == 0) {  // Empty list
+            p++;
+            break;
+        }
+
+        char* end;
+        float x = strtof(p, &end);
+        if (end == p || n == max) return -1;
+        out[n++] = x;
+        p = end;
+        while (isspace((unsigned char)*p)) p++;
+
+        if (*p == ',' && bracketed) {
+            p++;
+        } else if (*p == ']' && bracketed) {
+            p++;
+            break;
+        } else if (*p == '\0' && !bracketed) {
+            break;
+        } else {
+            return -1;
+        }
+    }
+    while (isspace((unsigned char)*p)) p++;
+    return *p == '\0' ? n : -1;
+}
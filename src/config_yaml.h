@@ -0,0 +1,51 @@
+/*
+ * config_yaml.h - Reader for the YAML subset of protocol_config.c
+ *
+ * Handles what the protocol file uses: nested block mappings by
+ * indentation, scalar values (quotes stripped), one-line flow sequences
+ * such as [0, 12] (kept as text, see yaml_parse_floats) and one-line flow
+ * mappings such as {dose_mg: 8.0, frequency: "BID"}, which are expanded
+ * into child keys. '#' starts a comment outside quotes. Block sequences,
+ * anchors and multi-line scalars are rejected with a message.
+ *
+ * Every key is stored with its full dotted path, in file order:
+ *
+ *   optimized_protocol.compounds.sr17018.dose_mg = 16.17
+ */
+
+#ifndef CONFIG_YAML_H
+#define CONFIG_YAML_H
+
+#include "patient_sim.h"
+
+#define YAML_KEY_LEN 160
+#define YAML_VALUE_LEN 160
+
+typedef struct {
+    char key[YAML_KEY_LEN];      // Dotted path
+    char value[YAML_VALUE_LEN];  // Empty for mappings
+    int depth;                   // Number of dots in key
+    int line;
+} YamlEntry;
+
+typedef struct {
+    int n;
+    int capacity;
+    YamlEntry* entries;
+} YamlDocument;
+
+// Returns 0, or -1 with a message naming the file and line
+int yaml_load(YamlDocument* doc, const char* path);
+void yaml_free(YamlDocument* doc);
+
+// Entry with exactly this dotted path, or NULL
+const YamlEntry* yaml_find(const YamlDocument* doc, const char* key);
+
+// Value of parent.child, or NULL if absent
+const char* yaml_child_value(const YamlDocument* doc, const char* parent, const char* child);
+
+// Parses "[a, b, ...]" or a bare number into out (at most max values);
+// returns the count, or -1 if the text is not a list of numbers
+int yaml_parse_floats(const char* value, float* out, int max);
+
+#endif // CONFIG_YAML_H
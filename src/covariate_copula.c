@@ -0,0 +1,135 @@
+/*
+ * covariate_copula.c - Correlated continuous covariates (Gaussian copula)
+ */
+
+#include "covariate_copula.h"
+
+static const char* const COVARIATE_NAMES[COPULA_N_COVARIATES] = {
+    "age", "weight", "bmi", "renal", "hepatic"
+};
+
+// Built-in correlations of an adult chronic-pain cohort (upper triangle):
+// eGFR and hepatic reserve decline with age, weight tracks BMI, and
+// renal and hepatic function move together
+static const double DEFAULT_CORRELATION[COPULA_N_COVARIATES][COPULA_N_COVARIATES] = {
+    //  age    weight   bmi    renal  hepatic
+    {1.00,  0.05,  0.10, -0.60, -0.25},  // age
+    {0.00,  1.00,  0.85,  0.20, -0.10},  // weight
+    {0.00,  0.00,  1.00, -0.05, -0.15},  // bmi
+    {0.00,  0.00,  0.00,  1.00,  0.20},  // renal
+    {0.00,  0.00,  0.00,  0.00,  1.00}   // hepatic
+};
+
+static CovariateCopula run_copula = {
+    .enabled = 0,
+    .correlation = {{1, 0, 0, 0, 0}, {0, 1, 0, 0, 0}, {0, 0, 1, 0, 0}, {0, 0, 0, 1, 0}, {0, 0, 0, 0, 1}},
+    .cholesky = {{1, 0, 0, 0, 0}, {0, 1, 0, 0, 0}, {0, 0, 1, 0, 0}, {0, 0, 0, 1, 0}, {0, 0, 0, 0, 1}}
+};
+
+void covariate_copula_init(CovariateCopula* c) {
+    memset(c, 0, sizeof(*c));
+    for (int d = 0; d < COPULA_N_COVARIATES; d++) {
+        c->correlation[d][d] = 1.0;
+        c->cholesky[d][d] = 1.0f;
+    }
+}
+
+static void set_correlation(CovariateCopula* c, int a, int b, double r) {
+    c->correlation[a][b] = r;
+    c->correlation[b][a] = r;
+}
+
+static int covariate_from_name(const char* name, int* covariate) {
+    for (int d = 0; d < COPULA_N_COVARIATES; d++) {
+        if (strcmp(name, COVARIATE_NAMES[d]) == 0) {
+            *covariate = d;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int covariate_copula_parse(CovariateCopula* c, const char* spec) {
+    c->enabled = 1;
+
+    char buffer[256];
+    if (snprintf(buffer, sizeof(buffer), "%s", spec) >= (int)sizeof(buffer)) {
+        fprintf(stderr, "Error: covariate correlation spec is longer than %d characters\n",
+                (int)sizeof(buffer) - 1);
+        return -1;
+    }
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        if (strcmp(item, "default") == 0) {
+            for (int a = 0; a < COPULA_N_COVARIATES; a++) {
+                for (int b = a + 1; b < COPULA_N_COVARIATES; b++) {
+                    set_correlation(c, a, b, DEFAULT_CORRELATION[a][b]);
+                }
+            }
+            continue;
+        }
+
+        char* colon = strchr(item, ':');
+        char* eq = strchr(item, '=');
+        char* end = NULL;
+        double r = eq ? strtod(eq + 1, &end) : 0;
+        if (!colon || !eq || colon > eq || end == eq + 1 || *end != '\0') {
+            fprintf(stderr, "Error: bad covariate correlation \"%s\" (expected default or "
+                            "name:name=r)\n", item);
+            return -1;
+        }
+
+        *colon = '\0';
+        *eq = '\0';
+        int a, b;
+        if (covariate_from_name(item, &a) != 0 || covariate_from_name(colon + 1, &b) != 0 || a == b) {
+            fprintf(stderr, "Error: covariate correlation %s:%s needs two different covariates "
+                            "of age, weight, bmi, renal, hepatic\n", item, colon + 1);
+            return -1;
+        }
+        if (!(r > -1 && r < 1)) {
+            fprintf(stderr, "Error: covariate correlation %s:%s must be in (-1, 1), got %g\n",
+                    item, colon + 1, r);
+            return -1;
+        }
+        set_correlation(c, a, b, r);
+    }
+
+    if (covariate_copula_factor(c) != 0) {
+        fprintf(stderr, "Error: covariate correlation matrix \"%s\" is not positive definite\n", spec);
+        return -1;
+    }
+    return 0;
+}
+
+int covariate_copula_factor(CovariateCopula* c) {
+    double l[COPULA_N_COVARIATES][COPULA_N_COVARIATES] = {{0}};
+    for (int i = 0; i < COPULA_N_COVARIATES; i++) {
+        for (int j = 0; j <= i; j++) {
+            double sum = c->correlation[i][j];
+            for (int k = 0; k < j; k++) sum -= l[i][k] * l[j][k];
+            if (i == j) {
+                if (sum <= 1e-9) return -1;
+                l[i][i] = sqrt(sum);
+            } else {
+                l[i][j] = sum / l[j][j];
+            }
+        }
+    }
+
+    for (int i = 0; i < COPULA_N_COVARIATES; i++) {
+        for (int j = 0; j < COPULA_N_COVARIATES; j++) c->cholesky[i][j] = (float)l[i][j];
+    }
+    return 0;
+}
+
+const char* covariate_copula_name(CopulaCovariate covariate) {
+    return covariate < COPULA_N_COVARIATES ? COVARIATE_NAMES[covariate] : "unknown";
+}
+
+void covariate_copula_set(const CovariateCopula* c) {
+    run_copula = *c;
+}
+
+const CovariateCopula* covariate_copula(void) {
+    return &run_copula;
+}
@@ -0,0 +1,94 @@
+/*
+ * covariate_copula.h - Correlated continuous covariates (Gaussian copula)
+ *
+ * population_gen.c draws age, weight, BMI, renal and hepatic function
+ * independently. With a copula the five draws are first expressed as
+ * standard normals (age through the normal quantile of its uniform),
+ * multiplied by the Cholesky factor L of a correlation matrix R, and
+ * mapped back (age through the normal CDF). The marginal distributions
+ * stay as before and the covariates gain the rank correlation of R, with
+ * one exception: hepatic function loses its fixed 0.1 drop over age 60,
+ * which R's age:hepatic entry replaces. It is centred on the same
+ * population mean, so a copula run gets the age dependence R specifies
+ * and not the step on top of it.
+ *
+ * L is computed once when the copula is configured, and population_gen.c
+ * applies it to a whole generation block at a time, row by row over
+ * columns, so the products vectorize.
+ *
+ * Disabled unless --covariate-correlation is given, so populations stay
+ * the same as before. Latin-hypercube columns (population_gen.h) are mixed
+ * by L, which keeps their marginals but not their one-per-cell property.
+ */
+
+#ifndef COVARIATE_COPULA_H
+#define COVARIATE_COPULA_H
+
+#include "patient_sim.h"
+
+typedef enum {
+    COPULA_AGE = 0,
+    COPULA_WEIGHT,
+    COPULA_BMI,
+    COPULA_RENAL,
+    COPULA_HEPATIC,
+    COPULA_N_COVARIATES
+} CopulaCovariate;
+
+typedef struct {
+    int enabled;
+    double correlation[COPULA_N_COVARIATES][COPULA_N_COVARIATES];
+    float cholesky[COPULA_N_COVARIATES][COPULA_N_COVARIATES];  // Lower factor of correlation
+} CovariateCopula;
+
+// Disabled, identity correlation
+void covariate_copula_init(CovariateCopula* c);
+
+/*
+ * Enables the copula from a comma-separated spec: "default" for the
+ * built-in adult pain-cohort correlations (eGFR falling with age, weight
+ * tracking BMI, ...), and/or pairs name:name=r with names age, weight,
+ * bmi, renal and hepatic, e.g.
+ *
+ *   default
+ *   age:renal=-0.6,weight:bmi=0.85
+ *   default,age:hepatic=-0.4
+ *
+ * Unlisted pairs are uncorrelated unless "default" sets them. Returns 0,
+ * or -1 with a message if a value is outside (-1, 1) or the matrix is not
+ * positive definite.
+ */
+int covariate_copula_parse(CovariateCopula* c, const char* spec);
+
+// Recomputes the Cholesky factor of c->correlation; returns 0, or -1 if
+// the matrix is not positive definite
+int covariate_copula_factor(CovariateCopula* c);
+
+const char* covariate_copula_name(CopulaCovariate covariate);
+
+// Run setting read by population generation; disabled until set
+void covariate_copula_set(const CovariateCopula* c);
+const CovariateCopula* covariate_copula(void);
+
+/*
+ * Correlates n independent standard normals per covariate in place:
+ * columns[d][j] becomes row d of L times patient j's vector. Rows are
+ * written from last to first, so each reads only columns not yet written.
+ */
+static inline void covariate_copula_apply(const CovariateCopula* c,
+                                          float* const columns[COPULA_N_COVARIATES], int n) {
+    for (int r = COPULA_N_COVARIATES - 1; r >= 0; r--) {
+        float* out = columns[r];
+        const float diagonal = c->cholesky[r][r];
+        #pragma omp simd
+        for (int j = 0; j < n; j++) out[j] *= diagonal;
+        for (int k = 0; k < r; k++) {
+            const float weight = c->cholesky[r][k];
+            const float* in = columns[k];
+            #pragma omp simd
+            for (int j = 0; j < n; j++) out[j] += weight * in[j];
+        }
+    }
+}
+
+#endif // COVARIATE_COPULA_H
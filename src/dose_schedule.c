@@ -0,0 +1,146 @@
+/*
+ * dose_schedule.c - Daily dosing schedules and their timestep event tables
+ */
+
+#include "dose_schedule.h"
+
+void dose_schedule_init(DoseSchedule* s) {
+    memset(s, 0, sizeof(*s));
+    s->n_phases = 1;
+}
+
+static int phase_is_empty(const DosePhase* phase) {
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        if (phase->n_doses[c] > 0) return 0;
+    }
+    return 1;
+}
+
+int dose_schedule_begin_phase(DoseSchedule* s, int start_day) {
+    if (s->n_phases == 1 && start_day == 0 && phase_is_empty(&s->phase[0])) return 0;
+    if (s->n_phases == DOSE_MAX_PHASES || start_day <= s->start_day[s->n_phases - 1]) return -1;
+
+    memset(&s->phase[s->n_phases], 0, sizeof(DosePhase));
+    s->start_day[s->n_phases] = start_day;
+    s->n_phases++;
+    return 0;
+}
+
+int dose_schedule_add(DoseSchedule* s, PkCompound compound, float hour, float dose_mg) {
+    if (hour < 0 || hour >= 24.0f || dose_mg < 0) return -1;
+    DosePhase* phase = &s->phase[s->n_phases - 1];
+    int n = phase->n_doses[compound];
+    if (n == DOSE_MAX_PER_DAY) return -1;
+    phase->hour[compound][n] = hour;
+    phase->dose_mg[compound][n] = dose_mg;
+    phase->n_doses[compound] = n + 1;
+    return 0;
+}
+
+void dose_schedule_from_protocol(DoseSchedule* s, const Protocol* protocol) {
+    dose_schedule_init(s);
+    for (int h = 0; h < 24; h += 12) dose_schedule_add(s, PK_SR17018, h, protocol->sr17018_dose);
+    dose_schedule_add(s, PK_SR14968, 0, protocol->sr14968_dose);
+    for (int h = 0; h < 24; h += 6) dose_schedule_add(s, PK_DPP26, h, protocol->dpp26_dose);
+}
+
+int dose_schedule_set_formulation(DoseSchedule* s, PkCompound compound,
+                                  PkFormulation formulation, float release_hours) {
+    if (release_hours < 0 || release_hours > 24.0f) return -1;
+    s->formulation[compound] = formulation;
+    s->release_hours[compound] = release_hours;
+    return 0;
+}
+
+int dose_frequency_per_day(const char* frequency) {
+    if (strcmp(frequency, "QD") == 0) return 1;
+    if (strcmp(frequency, "BID") == 0) return 2;
+    if (strcmp(frequency, "TID") == 0) return 3;
+    if (strcmp(frequency, "QID") == 0) return 4;
+
+    int hours;
+    char suffix, extra;
+    if (sscanf(frequency, "Q%d%c%c", &hours, &suffix, &extra) == 2 && suffix == 'H' &&
+        hours > 0 && hours <= 24 && 24 % hours == 0) {
+        return 24 / hours;
+    }
+    return 0;
+}
+
+Protocol dose_schedule_nominal(const DoseSchedule* s) {
+    float nominal[PK_N_COMPOUNDS] = {0};
+    for (int p = 0; p < s->n_phases; p++) {
+        const DosePhase* phase = &s->phase[p];
+        for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+            for (int d = 0; d < phase->n_doses[c]; d++) {
+                nominal[c] = fmaxf(nominal[c], phase->dose_mg[c][d]);
+            }
+        }
+    }
+    return (Protocol){.sr17018_dose = nominal[PK_SR17018],
+                      .sr14968_dose = nominal[PK_SR14968],
+                      .dpp26_dose = nominal[PK_DPP26]};
+}
+
+// First timestep starting at or after `hour`; the tolerance absorbs
+// rounding in hour * timesteps_per_day / 24 for doses on a step boundary
+static int dose_step(float hour, int timesteps_per_day) {
+    int step = (int)ceil((double)hour * timesteps_per_day / 24.0 - 1e-6);
+    return step < timesteps_per_day ? step : 0;
+}
+
+// Index of step in the ascending event steps of compound c, inserting it
+// (with zero doses in every phase) if needed; -1 if the table is full
+static int event_index(DoseEventTable* t, int c, int step) {
+    int n = t->n_events[c];
+    int e = 0;
+    while (e < n && t->step[c][e] < step) e++;
+    if (e < n && t->step[c][e] == step) return e;
+    if (n == DOSE_MAX_EVENTS) return -1;
+
+    for (int m = n; m > e; m--) {
+        t->step[c][m] = t->step[c][m - 1];
+        for (int p = 0; p < DOSE_MAX_PHASES; p++) t->dose_mg[p][c][m] = t->dose_mg[p][c][m - 1];
+    }
+    t->step[c][e] = step;
+    for (int p = 0; p < DOSE_MAX_PHASES; p++) t->dose_mg[p][c][e] = 0;
+    t->n_events[c] = n + 1;
+    return e;
+}
+
+int dose_events_compile(DoseEventTable* t, const DoseSchedule* s, int timesteps_per_day) {
+    memset(t, 0, sizeof(*t));
+    t->n_phases = s->n_phases;
+
+    for (int p = 0; p < s->n_phases; p++) {
+        const DosePhase* phase = &s->phase[p];
+        for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+            for (int d = 0; d < phase->n_doses[c]; d++) {
+                if (phase->dose_mg[c][d] == 0) continue;
+                int e = event_index(t, c, dose_step(phase->hour[c][d], timesteps_per_day));
+                if (e < 0) return -1;
+                t->dose_mg[p][c][e] += phase->dose_mg[c][d];
+            }
+        }
+    }
+
+    int p = 0;
+    for (int day = 0; day < SIMULATION_DAYS; day++) {
+        while (p + 1 < s->n_phases && s->start_day[p + 1] <= day) p++;
+        t->phase_of_day[day] = (uint8_t)p;
+    }
+
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        t->formulation[c] = s->formulation[c];
+        if (s->formulation[c] != PK_ZERO_ORDER_RELEASE) continue;
+
+        float hours = s->release_hours[c];
+        for (int q = 0; hours == 0 && q < s->n_phases; q++) {
+            if (s->phase[q].n_doses[c] > 0) hours = 24.0f / s->phase[q].n_doses[c];
+        }
+        float steps = roundf((hours > 0 ? hours : 24.0f) * timesteps_per_day / 24.0f);
+        t->release_steps[c] = fmaxf(steps, 1.0f);
+        t->zero_order = 1;
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * dose_schedule.h - Daily dosing schedules and their timestep event tables
+ *
+ * A DoseSchedule lists, per compound, the hours of the day at which a dose
+ * is given and its amount. Titration regimens are a sequence of phases,
+ * each with its own daily administrations, starting on a given treatment
+ * day; fixed-dose regimens have a single phase.
+ *
+ * Before simulating, a schedule is compiled for the timestep grid into a
+ * DoseEventTable: per compound, the ascending timesteps of the day that
+ * receive a dose in any phase, the mg each phase gives there (0 if none)
+ * and the phase of every treatment day. The kernels walk the event steps
+ * with one cursor per compound instead of testing the clock, and only look
+ * the phase up at day boundaries.
+ *
+ * A dose at hour h lands on the first timestep starting at or after h,
+ * which is where the former fmodf(hour, period) < dt checks put it, so
+ * dose_schedule_from_protocol() reproduces the hard-wired BID/QD/Q6H
+ * regimen on every grid. Doses falling on the same timestep are added; a
+ * dose after the last timestep of the day moves to the first one.
+ *
+ * Each compound also has a formulation (pk_engine.h), fixed for the whole
+ * schedule. A zero-order formulation releases every dose over release_hours,
+ * by default the dosing interval of the first phase that gives the compound.
+ * The event table records the release period in timesteps and whether any
+ * compound needs the depot, so the batch kernel can keep immediate-release
+ * schedules on a code path without it.
+ */
+
+#ifndef DOSE_SCHEDULE_H
+#define DOSE_SCHEDULE_H
+
+#include "patient_sim.h"
+#include "pk_engine.h"
+
+#define DOSE_MAX_PER_DAY 24  // Administrations per compound and day
+#define DOSE_MAX_PHASES 8
+#define DOSE_MAX_EVENTS 48   // Distinct dose timesteps per compound over all phases
+
+typedef struct {
+    int n_doses[PK_N_COMPOUNDS];
+    float hour[PK_N_COMPOUNDS][DOSE_MAX_PER_DAY];     // In [0, 24)
+    float dose_mg[PK_N_COMPOUNDS][DOSE_MAX_PER_DAY];
+} DosePhase;
+
+typedef struct {
+    int n_phases;
+    int start_day[DOSE_MAX_PHASES];                   // Ascending; phase 0 starts on day 0
+    DosePhase phase[DOSE_MAX_PHASES];
+    PkFormulation formulation[PK_N_COMPOUNDS];
+    float release_hours[PK_N_COMPOUNDS];              // Zero-order only; 0 = dosing interval
+} DoseSchedule;
+
+typedef struct {
+    int n_phases;
+    int n_events[PK_N_COMPOUNDS];
+    int step[PK_N_COMPOUNDS][DOSE_MAX_EVENTS];        // Ascending timestep of the day
+    float dose_mg[DOSE_MAX_PHASES][PK_N_COMPOUNDS][DOSE_MAX_EVENTS];
+    uint8_t phase_of_day[SIMULATION_DAYS];
+    PkFormulation formulation[PK_N_COMPOUNDS];
+    float release_steps[PK_N_COMPOUNDS];              // Zero-order release period
+    int zero_order;                                   // Any compound uses the depot
+} DoseEventTable;
+
+// Empty single-phase schedule: no compound is given, all immediate release
+void dose_schedule_init(DoseSchedule* s);
+
+// The fixed regimen of the original kernels: SR-17018 BID, SR-14968 QD and
+// DPP-26 Q6H, first doses at hour 0
+void dose_schedule_from_protocol(DoseSchedule* s, const Protocol* protocol);
+
+// Starts a new, empty phase on start_day. The first call replaces an empty
+// phase 0 if start_day is 0. Returns 0, or -1 if start_day does not come
+// after the previous phase or there are DOSE_MAX_PHASES phases already.
+int dose_schedule_begin_phase(DoseSchedule* s, int start_day);
+
+// Adds an administration to the last phase. Returns 0, or -1 if hour is
+// outside [0, 24), the dose is negative or the compound already has
+// DOSE_MAX_PER_DAY administrations in the phase.
+int dose_schedule_add(DoseSchedule* s, PkCompound compound, float hour, float dose_mg);
+
+// Sets the formulation of a compound for every phase. release_hours only
+// applies to PK_ZERO_ORDER_RELEASE (0 for the dosing interval). Returns 0,
+// or -1 if release_hours is negative or longer than a day.
+int dose_schedule_set_formulation(DoseSchedule* s, PkCompound compound,
+                                  PkFormulation formulation, float release_hours);
+
+// Administrations per day for QD, BID, TID, QID and Q<n>H (n dividing 24);
+// 0 if the name is not recognized
+int dose_frequency_per_day(const char* frequency);
+
+// Largest single dose of each compound over all phases, for reports and
+// CSV columns
+Protocol dose_schedule_nominal(const DoseSchedule* s);
+
+// Returns 0, or -1 if the phases need more than DOSE_MAX_EVENTS distinct
+// timesteps for a compound
+int dose_events_compile(DoseEventTable* t, const DoseSchedule* s, int timesteps_per_day);
+
+#endif // DOSE_SCHEDULE_H
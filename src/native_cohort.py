@@ -0,0 +1,289 @@
+"""
+Native cohort generation for PatientGenerationConfig populations.
+
+Binds the C generator in cohort_gen.c through ctypes. A cohort of millions of
+patients is drawn in C as columns (one Philox stream per patient, spread over
+the OpenMP threads); `NativeCohort.to_profiles()` turns them into the
+PatientProfile list PatientGenerator returns. The distributions are those of
+PatientGenerator.generate_patient; the individual draws differ from numpy's.
+
+Build the library next to this file (or point ZEROPAIN_COHORT_LIB at it):
+    gcc -O3 -march=native -fopenmp -shared -fPIC cohort_gen.c sim_rng.c \
+        -lm -o libzp_cohort.so
+"""
+
+from __future__ import annotations
+
+import ctypes
+import os
+from pathlib import Path
+from typing import Dict, List, Optional
+
+LIBRARY_ENV = "ZEROPAIN_COHORT_LIB"
+LIBRARY_NAME = "libzp_cohort.so"
+
+# Mirrors of cohort_gen.h; the library refuses to bind on a layout mismatch
+ABI_VERSION = 1
+MAX_MEDICATIONS = 16
+MAX_CONDITIONS = 16
+
+# Conditions PatientGenerator lets slow metabolism when present
+CONDITION_METABOLISM = {
+    "liver_disease": 0.6,
+    "kidney_disease": 0.7,
+}
+
+
+class _Medication(ctypes.Structure):
+    _fields_ = [
+        ("prevalence", ctypes.c_float),
+        ("metabolism_multiplier", ctypes.c_float),
+        ("sensitivity_multiplier", ctypes.c_float),
+        ("analgesia_bonus", ctypes.c_float),
+        ("side_effect_bias", ctypes.c_float),
+        ("baseline_tolerance", ctypes.c_float),
+    ]
+
+
+class _Condition(ctypes.Structure):
+    _fields_ = [
+        ("prevalence", ctypes.c_float),
+        ("metabolism_multiplier", ctypes.c_float),
+    ]
+
+
+class _CohortSpec(ctypes.Structure):
+    _fields_ = [
+        ("sex_ratio_male", ctypes.c_float),
+        ("age_alpha", ctypes.c_float),
+        ("age_beta", ctypes.c_float),
+        ("min_age", ctypes.c_int32),
+        ("max_age", ctypes.c_int32),
+        ("male_weight_mean", ctypes.c_float),
+        ("male_weight_std", ctypes.c_float),
+        ("female_weight_mean", ctypes.c_float),
+        ("female_weight_std", ctypes.c_float),
+        ("min_weight", ctypes.c_float),
+        ("max_weight", ctypes.c_float),
+        ("pain_alpha", ctypes.c_float),
+        ("pain_beta", ctypes.c_float),
+        ("sensitivity_mean", ctypes.c_float),
+        ("sensitivity_sigma", ctypes.c_float),
+        ("metabolism_sigma", ctypes.c_float),
+        ("n_medications", ctypes.c_int32),
+        ("n_conditions", ctypes.c_int32),
+        ("medications", _Medication * MAX_MEDICATIONS),
+        ("conditions", _Condition * MAX_CONDITIONS),
+    ]
+
+
+# Output columns of cohort_gen.h CohortColumns, in order
+COLUMNS = [
+    ("patient_id", ctypes.c_int32),
+    ("age", ctypes.c_int32),
+    ("weight", ctypes.c_float),
+    ("male", ctypes.c_uint8),
+    ("metabolism_rate", ctypes.c_float),
+    ("sensitivity", ctypes.c_float),
+    ("pain_severity", ctypes.c_float),
+    ("medications", ctypes.c_uint16),
+    ("conditions", ctypes.c_uint16),
+    ("baseline_tolerance", ctypes.c_float),
+    ("metabolism_multiplier", ctypes.c_float),
+    ("sensitivity_multiplier", ctypes.c_float),
+    ("analgesia_bonus", ctypes.c_float),
+    ("side_effect_bias", ctypes.c_float),
+]
+
+
+class _CohortColumns(ctypes.Structure):
+    _fields_ = [(name, ctypes.POINTER(ctype)) for name, ctype in COLUMNS]
+
+
+_library: Optional[ctypes.CDLL] = None
+_library_error: Optional[str] = None
+
+
+def load_library(path: Optional[str] = None) -> ctypes.CDLL:
+    """Load and check the cohort library; raises OSError if unavailable."""
+    global _library
+    if _library is not None and path is None:
+        return _library
+
+    candidate = path or os.environ.get(LIBRARY_ENV) or str(Path(__file__).resolve().parent / LIBRARY_NAME)
+    lib = ctypes.CDLL(candidate)
+    lib.cohort_abi_version.restype = ctypes.c_int
+    lib.cohort_spec_bytes.restype = ctypes.c_size_t
+    lib.cohort_columns_bytes.restype = ctypes.c_size_t
+    lib.cohort_generate.restype = ctypes.c_int
+    lib.cohort_generate.argtypes = [
+        ctypes.POINTER(_CohortSpec),
+        ctypes.c_uint64,
+        ctypes.c_int,
+        ctypes.c_int,
+        ctypes.POINTER(_CohortColumns),
+    ]
+
+    if (
+        lib.cohort_abi_version() != ABI_VERSION
+        or lib.cohort_spec_bytes() != ctypes.sizeof(_CohortSpec)
+        or lib.cohort_columns_bytes() != ctypes.sizeof(_CohortColumns)
+    ):
+        raise OSError(f"{candidate} was built from a different cohort_gen.h")
+
+    if path is None:
+        _library = lib
+    return lib
+
+
+def native_available() -> bool:
+    """True if the cohort library can be loaded."""
+    global _library_error
+    if _library is not None:
+        return True
+    if _library_error is not None:
+        return False
+    try:
+        load_library()
+        return True
+    except OSError as exc:
+        _library_error = str(exc)
+        return False
+
+
+def _default_config():
+    from patient_simulation_100k import PatientGenerationConfig
+
+    return PatientGenerationConfig()
+
+
+def supports_config(config) -> bool:
+    """True if the native spec can hold config's medications and comorbidities."""
+    return (
+        len(config.pre_existing_medications) <= MAX_MEDICATIONS
+        and len(config.comorbidity_prevalence) <= MAX_CONDITIONS
+    )
+
+
+def spec_from_config(config) -> _CohortSpec:
+    """Native spec of a PatientGenerationConfig."""
+    medications = list(config.pre_existing_medications.values())
+    conditions = list(config.comorbidity_prevalence.items())
+    if not supports_config(config):
+        raise ValueError(
+            f"native cohorts support up to {MAX_MEDICATIONS} medications and "
+            f"{MAX_CONDITIONS} comorbidities"
+        )
+
+    age = config.age_distribution
+    weight = config.weight_distribution
+    spec = _CohortSpec(
+        sex_ratio_male=config.sex_ratio_male,
+        age_alpha=age.alpha,
+        age_beta=age.beta,
+        min_age=int(age.min_age),
+        max_age=int(age.max_age),
+        male_weight_mean=weight.male_mean,
+        male_weight_std=weight.male_std,
+        female_weight_mean=weight.female_mean,
+        female_weight_std=weight.female_std,
+        min_weight=weight.min_weight,
+        max_weight=weight.max_weight,
+        pain_alpha=config.pain_alpha,
+        pain_beta=config.pain_beta,
+        sensitivity_mean=config.sensitivity_mean,
+        sensitivity_sigma=config.sensitivity_sigma,
+        metabolism_sigma=config.metabolism_sigma,
+        n_medications=len(medications),
+        n_conditions=len(conditions),
+    )
+    for slot, med in zip(spec.medications, medications):
+        slot.prevalence = med.prevalence
+        slot.metabolism_multiplier = med.metabolism_multiplier
+        slot.sensitivity_multiplier = med.sensitivity_multiplier
+        slot.analgesia_bonus = med.analgesia_bonus
+        slot.side_effect_bias = med.side_effect_bias
+        slot.baseline_tolerance = med.baseline_tolerance
+    for slot, (name, prevalence) in zip(spec.conditions, conditions):
+        slot.prevalence = prevalence
+        slot.metabolism_multiplier = CONDITION_METABOLISM.get(name, 1.0)
+    return spec
+
+
+class NativeCohort:
+    """Columns of a natively generated cohort."""
+
+    def __init__(self, columns: Dict[str, ctypes.Array],
+                 medication_names: List[str], condition_names: List[str]):
+        self.columns = columns
+        self.medication_names = medication_names
+        self.condition_names = condition_names
+
+    def __len__(self) -> int:
+        return len(self.columns["patient_id"])
+
+    def to_numpy(self) -> Dict[str, "np.ndarray"]:
+        """Zero-copy numpy views of the columns."""
+        import numpy as np
+
+        return {name: np.ctypeslib.as_array(column) for name, column in self.columns.items()}
+
+    def to_profiles(self) -> List["PatientProfile"]:
+        """PatientProfile objects, as PatientGenerator.generate_population returns."""
+        from patient_simulation_100k import PatientProfile
+
+        return [PatientProfile(**fields) for fields in self.iter_profile_fields()]
+
+    def iter_profile_fields(self):
+        """PatientProfile keyword arguments, patient by patient."""
+        c = {name: column[:] for name, column in self.columns.items()}
+        for i in range(len(self)):
+            med_bits = c["medications"][i]
+            condition_bits = c["conditions"][i]
+            yield {
+                "patient_id": c["patient_id"][i],
+                "age": c["age"][i],
+                "weight": c["weight"][i],
+                "sex": "M" if c["male"][i] else "F",
+                "metabolism_rate": c["metabolism_rate"][i],
+                "sensitivity": c["sensitivity"][i],
+                "pain_severity": c["pain_severity"][i],
+                "comorbidities": [name for b, name in enumerate(self.condition_names) if condition_bits >> b & 1],
+                "medications": [name for b, name in enumerate(self.medication_names) if med_bits >> b & 1],
+                "baseline_tolerance": c["baseline_tolerance"][i],
+                "medication_effects": {
+                    "metabolism_multiplier": c["metabolism_multiplier"][i],
+                    "sensitivity_multiplier": c["sensitivity_multiplier"][i],
+                    "analgesia_bonus": c["analgesia_bonus"][i],
+                    "side_effect_bias": c["side_effect_bias"][i],
+                    "baseline_tolerance": c["baseline_tolerance"][i],
+                },
+            }
+
+
+def generate_cohort(n_patients: int, seed: Optional[int] = 42, config=None,
+                    first: int = 0) -> NativeCohort:
+    """
+    Patients [first, first + n_patients) of the cohort described by config
+    (a PatientGenerationConfig; its defaults if None). Seed None draws a
+    fresh cohort.
+    """
+    lib = load_library()
+    cfg = config if config is not None else _default_config()
+    spec = spec_from_config(cfg)
+    if seed is None:
+        seed = int.from_bytes(os.urandom(8), "little")
+
+    columns = {name: (ctype * n_patients)() for name, ctype in COLUMNS}
+    pointers = _CohortColumns(*[
+        ctypes.cast(columns[name], ctypes.POINTER(ctype)) for name, ctype in COLUMNS
+    ])
+    if lib.cohort_generate(ctypes.byref(spec), seed & (2**64 - 1), first, n_patients,
+                           ctypes.byref(pointers)) != 0:
+        raise ValueError("invalid cohort configuration (see stderr)")
+
+    return NativeCohort(
+        columns,
+        medication_names=[med.name for med in cfg.pre_existing_medications.values()],
+        condition_names=list(cfg.comorbidity_prevalence.keys()),
+    )
@@ -0,0 +1,162 @@
+/*
+ * outcome_record.c - Compact per-patient treatment outcome
+ */
+
+#include "outcome_record.h"
+#include "outcome_stats.h"
+#include "sim_config.h"
+
+// ============================================================================
+// DISCONTINUATION REASONS
+// ============================================================================
+
+static const char* const reason_names[N_DISCONTINUATION_REASONS] = {
+    "completed",
+    "inadequate_analgesia",
+    "non_adherence",
+    "trial_failure",
+    "other"
+};
+
+const char* discontinuation_reason_name(DiscontinuationReason reason) {
+    return reason >= 0 && reason < N_DISCONTINUATION_REASONS ? reason_names[reason] : "other";
+}
+
+DiscontinuationReason discontinuation_reason_from_name(const char* name) {
+    if (name[0] == '\0') return REASON_COMPLETED;
+    for (int r = REASON_INADEQUATE_ANALGESIA; r < REASON_OTHER; r++) {
+        if (strcmp(name, reason_names[r]) == 0) return (DiscontinuationReason)r;
+    }
+    return REASON_OTHER;
+}
+
+// ============================================================================
+// RECORDS
+// ============================================================================
+
+void outcome_record_finalize(CompactOutcome* r, int patient_id, DiscontinuationReason reason,
+                             int day, float cumulative_analgesia, float tolerance,
+                             float max_beta_arrestin, int adverse_events, float total_cost,
+                             int withdrawal) {
+    r->patient_id = patient_id;
+    r->reason = (uint8_t)reason;
+    r->avg_pain_reduction = cumulative_analgesia / (sim_days() * sim_timesteps_per_day());
+    r->final_tolerance_level = tolerance;
+    r->total_cost = total_cost;
+    r->adverse_event_count = adverse_events < UINT16_MAX ? (uint16_t)adverse_events : UINT16_MAX;
+
+    r->flags = 0;
+    if (tolerance > TOLERANCE_THRESHOLD) r->flags |= OUTCOME_TOLERANCE;
+    if (max_beta_arrestin > ADDICTION_RISK_THRESHOLD / 100.0) r->flags |= OUTCOME_ADDICTION;
+    if (withdrawal) r->flags |= OUTCOME_WITHDRAWAL;
+
+    // QALY calculation
+    float qaly_days = day > 0 ? day : sim_days();
+    r->qaly_gained = (qaly_days / DAYS_PER_YEAR) * QALY_UTILITY_GAIN_FACTOR * r->avg_pain_reduction;
+
+    // Success determination
+    if (day == 0) {
+        r->flags |= OUTCOME_SUCCESS;
+        day = sim_days();
+    }
+    r->discontinuation_day = (uint16_t)day;
+}
+
+int outcome_record_trace_days(const CompactOutcome* r) {
+    if (r->reason == REASON_COMPLETED) return sim_days();
+    if (r->flags & OUTCOME_SUCCESS) return 1;  // Stopped on day 0
+    return r->discontinuation_day + 1;
+}
+
+void outcome_record_from_treatment(CompactOutcome* r, const TreatmentOutcome* outcome) {
+    r->patient_id = outcome->patient_id;
+    r->avg_pain_reduction = outcome->avg_pain_reduction;
+    r->final_tolerance_level = outcome->final_tolerance_level;
+    r->total_cost = outcome->total_cost;
+    r->qaly_gained = outcome->qaly_gained;
+    r->discontinuation_day = (uint16_t)outcome->discontinuation_day;
+    r->adverse_event_count = outcome->adverse_event_count < UINT16_MAX
+                                 ? (uint16_t)outcome->adverse_event_count : UINT16_MAX;
+    r->reason = (uint8_t)discontinuation_reason_from_name(outcome->discontinuation_reason);
+    r->flags = (outcome->treatment_success ? OUTCOME_SUCCESS : 0)
+             | (outcome->tolerance_developed ? OUTCOME_TOLERANCE : 0)
+             | (outcome->addiction_signs ? OUTCOME_ADDICTION : 0)
+             | (outcome->withdrawal_occurred ? OUTCOME_WITHDRAWAL : 0);
+}
+
+void outcome_record_apply(const CompactOutcome* r, TreatmentOutcome* out) {
+    out->patient_id = r->patient_id;
+    out->treatment_success = (r->flags & OUTCOME_SUCCESS) != 0;
+    out->discontinuation_day = r->discontinuation_day;
+    strcpy(out->discontinuation_reason,
+           r->reason == REASON_COMPLETED ? "" : discontinuation_reason_name(r->reason));
+    out->avg_pain_reduction = r->avg_pain_reduction;
+    out->tolerance_developed = (r->flags & OUTCOME_TOLERANCE) != 0;
+    out->addiction_signs = (r->flags & OUTCOME_ADDICTION) != 0;
+    out->withdrawal_occurred = (r->flags & OUTCOME_WITHDRAWAL) != 0;
+    out->adverse_event_count = r->adverse_event_count;
+    out->final_tolerance_level = r->final_tolerance_level;
+    out->total_cost = r->total_cost;
+    out->qaly_gained = r->qaly_gained;
+}
+
+void outcome_record_expand(const CompactOutcome* r, const float* pain, const float* analgesia,
+                           int days, TreatmentOutcome* out) {
+    memset(out, 0, sizeof(*out));
+    outcome_record_apply(r, out);
+    if (pain) memcpy(out->daily_pain_scores, pain, days * sizeof(float));
+    if (analgesia) memcpy(out->analgesia_achieved, analgesia, days * sizeof(float));
+}
+
+// ============================================================================
+// KERNEL OUTPUT
+// ============================================================================
+
+void outcome_sink_emit(const OutcomeSink* sink, OutcomeStats* stats, int i,
+                       const CompactOutcome* r, const float* pain, const float* analgesia) {
+    int days = outcome_record_trace_days(r);
+
+    if (sink->records) sink->records[i] = *r;
+    if (sink->traces) trace_store_put(sink->traces, i, pain, analgesia, days);
+    if (sink->outcomes) outcome_record_expand(r, pain, analgesia, days, &sink->outcomes[i]);
+    if (stats) outcome_stats_add(stats, r, sink->weights ? sink->weights[i] : 1.0f);
+}
+
+int outcome_records_save_csv(const CompactOutcome* records, const TraceStore* traces,
+                             const float* weights, int n, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+
+    fprintf(f, "patient_id,treatment_success,discontinuation_day,discontinuation_reason,"
+               "avg_pain_reduction,tolerance_developed,addiction_signs,withdrawal_occurred,"
+               "adverse_event_count,final_tolerance_level,total_cost,qaly_gained");
+    if (traces) fprintf(f, ",trace_days,mean_daily_pain,final_daily_pain");
+    if (weights) fprintf(f, ",sample_weight");
+    fprintf(f, "\n");
+
+    float pain[SIMULATION_DAYS], analgesia[SIMULATION_DAYS];
+    for (int i = 0; i < n; i++) {
+        const CompactOutcome* r = &records[i];
+        fprintf(f, "%d,%d,%d,%s,%.6f,%d,%d,%d,%d,%.6f,%.2f,%.6f",
+                r->patient_id, (r->flags & OUTCOME_SUCCESS) != 0, r->discontinuation_day,
+                discontinuation_reason_name(r->reason), r->avg_pain_reduction,
+                (r->flags & OUTCOME_TOLERANCE) != 0, (r->flags & OUTCOME_ADDICTION) != 0,
+                (r->flags & OUTCOME_WITHDRAWAL) != 0, r->adverse_event_count,
+                r->final_tolerance_level, r->total_cost, r->qaly_gained);
+
+        if (traces) {
+            int days = trace_store_get(traces, i, pain, analgesia);
+            float sum = 0;
+            for (int d = 0; d < days; d++) sum += pain[d];
+            fprintf(f, ",%d,%.4f,%.4f", days, days ? sum / days : 0.0f, days ? pain[days - 1] : 0.0f);
+        }
+        if (weights) fprintf(f, ",%.6g", weights[i]);
+        fprintf(f, "\n");
+    }
+
+    fclose(f);
+    return 0;
+}
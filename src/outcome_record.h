@@ -0,0 +1,94 @@
+/*
+ * outcome_record.h - Compact per-patient treatment outcome
+ *
+ * CompactOutcome carries the end-of-treatment fields of TreatmentOutcome
+ * in 24 bytes: the discontinuation reason as an enum instead of a string,
+ * a 16-bit day and packed flags. Daily traces live in an optional
+ * TraceStore (trace_store.h) sized to the days actually simulated.
+ * outcome_record_expand() rebuilds the full TreatmentOutcome for the CSV
+ * export and calculate_statistics().
+ */
+
+#ifndef OUTCOME_RECORD_H
+#define OUTCOME_RECORD_H
+
+#include "patient_sim.h"
+#include "trace_store.h"
+#include <stdint.h>
+
+typedef enum {
+    REASON_COMPLETED = 0,            // No discontinuation
+    REASON_INADEQUATE_ANALGESIA,
+    REASON_NON_ADHERENCE,
+    REASON_TRIAL_FAILURE,
+    REASON_OTHER,
+    N_DISCONTINUATION_REASONS
+} DiscontinuationReason;
+
+const char* discontinuation_reason_name(DiscontinuationReason reason);
+DiscontinuationReason discontinuation_reason_from_name(const char* name);
+
+// CompactOutcome.flags
+#define OUTCOME_SUCCESS    0x01
+#define OUTCOME_TOLERANCE  0x02
+#define OUTCOME_ADDICTION  0x04
+#define OUTCOME_WITHDRAWAL 0x08
+
+typedef struct {
+    int32_t patient_id;
+    float avg_pain_reduction;
+    float final_tolerance_level;
+    float total_cost;
+    float qaly_gained;
+    uint16_t discontinuation_day;
+    uint16_t adverse_event_count;  // Saturates at UINT16_MAX
+    uint8_t reason;                // DiscontinuationReason
+    uint8_t flags;
+} CompactOutcome;
+
+// End-of-treatment outcome of a patient who stopped on `day` for `reason`
+// (REASON_COMPLETED and day 0 if the treatment ran its course). Keeps the
+// legacy rule that a day-0 stop counts as success for the full sim_days().
+// withdrawal comes from the episode model of withdrawal_model.h.
+void outcome_record_finalize(CompactOutcome* r, int patient_id, DiscontinuationReason reason,
+                             int day, float cumulative_analgesia, float tolerance,
+                             float max_beta_arrestin, int adverse_events, float total_cost,
+                             int withdrawal);
+
+// Days of trace a finished patient has (through the stopping day)
+int outcome_record_trace_days(const CompactOutcome* r);
+
+void outcome_record_from_treatment(CompactOutcome* r, const TreatmentOutcome* outcome);
+
+// Copies the end-of-treatment fields into out; daily arrays are untouched
+void outcome_record_apply(const CompactOutcome* r, TreatmentOutcome* out);
+
+// Full record; pain/analgesia may be NULL, days beyond the trace stay zero
+void outcome_record_expand(const CompactOutcome* r, const float* pain, const float* analgesia,
+                           int days, TreatmentOutcome* out);
+
+// ============================================================================
+// KERNEL OUTPUT
+// ============================================================================
+
+typedef struct OutcomeStats OutcomeStats;
+
+// Where the kernels deliver finished patients; every member may be NULL
+typedef struct {
+    TreatmentOutcome* outcomes;  // Full legacy records, indexed by population index
+    CompactOutcome* records;     // Compact records, indexed by population index
+    TraceStore* traces;
+    OutcomeStats* stats;         // Merged result of the per-thread accumulators
+    const float* weights;        // Sample weight per population index; NULL = all 1
+} OutcomeSink;
+
+// Delivers patient i; stats is the calling thread's accumulator
+void outcome_sink_emit(const OutcomeSink* sink, OutcomeStats* stats, int i,
+                       const CompactOutcome* r, const float* pain, const float* analgesia);
+
+// Writes compact records (and trace summaries if traces is non-NULL) as CSV,
+// with a sample_weight column if weights is non-NULL
+int outcome_records_save_csv(const CompactOutcome* records, const TraceStore* traces,
+                             const float* weights, int n, const char* path);
+
+#endif // OUTCOME_RECORD_H
@@ -0,0 +1,372 @@
+/*
+ * outcome_stats.c - Streaming, mergeable population outcome statistics
+ */
+
+#include "outcome_stats.h"
+#include "sim_config.h"
+#include <float.h>
+
+// ============================================================================
+// ACCUMULATORS
+// ============================================================================
+
+void welford_init(Welford* w) {
+    w->n = 0;
+    w->sum_w = 0;
+    w->sum_w2 = 0;
+    w->mean = 0;
+    w->m2 = 0;
+    w->min = DBL_MAX;
+    w->max = -DBL_MAX;
+}
+
+void welford_merge(Welford* into, const Welford* from) {
+    if (from->n == 0) return;
+    if (into->n == 0) {
+        *into = *from;
+        return;
+    }
+
+    double sum_w = into->sum_w + from->sum_w;
+    double delta = from->mean - into->mean;
+    into->mean += delta * from->sum_w / sum_w;
+    into->m2 += from->m2 + delta * delta * (into->sum_w * from->sum_w / sum_w);
+    into->n += from->n;
+    into->sum_w = sum_w;
+    into->sum_w2 += from->sum_w2;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+}
+
+double welford_variance(const Welford* w) {
+    return w->n > 1 ? w->m2 / w->sum_w * ((double)w->n / (w->n - 1)) : 0.0;
+}
+
+double welford_standard_error(const Welford* w) {
+    if (w->n == 0) return 0.0;
+    double n_eff = w->sum_w * w->sum_w / w->sum_w2;
+    return sqrt(welford_variance(w) / n_eff);
+}
+
+void histogram_init(Histogram* h, double lo, double hi) {
+    memset(h, 0, sizeof(*h));
+    h->lo = lo;
+    h->hi = hi;
+}
+
+void histogram_merge(Histogram* into, const Histogram* from) {
+    into->below += from->below;
+    into->above += from->above;
+    for (int b = 0; b < STATS_HISTOGRAM_BINS; b++) {
+        into->bins[b] += from->bins[b];
+    }
+}
+
+double histogram_quantile(const Histogram* h, double q) {
+    double total = h->below + h->above;
+    for (int b = 0; b < STATS_HISTOGRAM_BINS; b++) total += h->bins[b];
+    if (total == 0) return 0.0;
+
+    double rank = q * total;
+    double seen = h->below;
+    if (rank <= seen) return h->lo;
+
+    double width = (h->hi - h->lo) / STATS_HISTOGRAM_BINS;
+    for (int b = 0; b < STATS_HISTOGRAM_BINS; b++) {
+        if (h->bins[b] > 0 && rank <= seen + h->bins[b]) {
+            return h->lo + width * (b + (rank - seen) / h->bins[b]);
+        }
+        seen += h->bins[b];
+    }
+    return h->hi;
+}
+
+// ============================================================================
+// POPULATION OUTCOME STATISTICS
+// ============================================================================
+
+void outcome_stats_init(OutcomeStats* s) {
+    memset(s, 0, sizeof(*s));
+    welford_init(&s->pain_reduction);
+    welford_init(&s->final_tolerance);
+    welford_init(&s->discontinuation_day);
+    welford_init(&s->adverse_events);
+    welford_init(&s->cost);
+    welford_init(&s->qaly);
+    histogram_init(&s->pain_reduction_hist, 0.0, 1.5);
+    histogram_init(&s->final_tolerance_hist, 0.0, 2.0);
+    histogram_init(&s->discontinuation_day_hist, 0.0, sim_days() + 1);
+}
+
+void outcome_stats_add(OutcomeStats* s, const CompactOutcome* outcome, double weight) {
+    s->n++;
+    s->weight += weight;
+    s->n_success += weight * ((outcome->flags & OUTCOME_SUCCESS) != 0);
+    s->n_tolerance += weight * ((outcome->flags & OUTCOME_TOLERANCE) != 0);
+    s->n_addiction += weight * ((outcome->flags & OUTCOME_ADDICTION) != 0);
+    s->n_withdrawal += weight * ((outcome->flags & OUTCOME_WITHDRAWAL) != 0);
+    s->n_reason[outcome->reason < N_DISCONTINUATION_REASONS ? outcome->reason : REASON_OTHER] += weight;
+
+    s->total_cost += weight * outcome->total_cost;
+    s->total_qaly += weight * outcome->qaly_gained;
+    s->total_adverse_events += weight * outcome->adverse_event_count;
+
+    welford_add_weighted(&s->pain_reduction, outcome->avg_pain_reduction, weight);
+    welford_add_weighted(&s->final_tolerance, outcome->final_tolerance_level, weight);
+    welford_add_weighted(&s->discontinuation_day, outcome->discontinuation_day, weight);
+    welford_add_weighted(&s->adverse_events, outcome->adverse_event_count, weight);
+    welford_add_weighted(&s->cost, outcome->total_cost, weight);
+    welford_add_weighted(&s->qaly, outcome->qaly_gained, weight);
+
+    histogram_add(&s->pain_reduction_hist, outcome->avg_pain_reduction, weight);
+    histogram_add(&s->final_tolerance_hist, outcome->final_tolerance_level, weight);
+    histogram_add(&s->discontinuation_day_hist, outcome->discontinuation_day, weight);
+}
+
+void outcome_stats_merge(OutcomeStats* into, const OutcomeStats* from) {
+    into->n += from->n;
+    into->weight += from->weight;
+    into->n_success += from->n_success;
+    into->n_tolerance += from->n_tolerance;
+    into->n_addiction += from->n_addiction;
+    into->n_withdrawal += from->n_withdrawal;
+    for (int r = 0; r < N_DISCONTINUATION_REASONS; r++) {
+        into->n_reason[r] += from->n_reason[r];
+    }
+
+    into->total_cost += from->total_cost;
+    into->total_qaly += from->total_qaly;
+    into->total_adverse_events += from->total_adverse_events;
+
+    welford_merge(&into->pain_reduction, &from->pain_reduction);
+    welford_merge(&into->final_tolerance, &from->final_tolerance);
+    welford_merge(&into->discontinuation_day, &from->discontinuation_day);
+    welford_merge(&into->adverse_events, &from->adverse_events);
+    welford_merge(&into->cost, &from->cost);
+    welford_merge(&into->qaly, &from->qaly);
+
+    histogram_merge(&into->pain_reduction_hist, &from->pain_reduction_hist);
+    histogram_merge(&into->final_tolerance_hist, &from->final_tolerance_hist);
+    histogram_merge(&into->discontinuation_day_hist, &from->discontinuation_day_hist);
+}
+
+// ============================================================================
+// ENDPOINTS
+// ============================================================================
+
+static const char* const ENDPOINT_NAMES[N_ENDPOINTS] = {
+    "success", "tolerance", "addiction", "pain_reduction"
+};
+
+const char* endpoint_name(Endpoint e) {
+    return e >= 0 && e < N_ENDPOINTS ? ENDPOINT_NAMES[e] : "unknown";
+}
+
+int endpoint_from_name(const char* name, Endpoint* e) {
+    for (int i = 0; i < N_ENDPOINTS; i++) {
+        if (strcmp(name, ENDPOINT_NAMES[i]) == 0) {
+            *e = (Endpoint)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+double outcome_stats_endpoint(const OutcomeStats* s, Endpoint e, double* standard_error) {
+    if (e == ENDPOINT_PAIN_REDUCTION) {
+        *standard_error = welford_standard_error(&s->pain_reduction);
+        return s->pain_reduction.mean;
+    }
+
+    double count = e == ENDPOINT_SUCCESS_RATE ? s->n_success
+                 : e == ENDPOINT_TOLERANCE_RATE ? s->n_tolerance
+                 : s->n_addiction;
+    if (s->weight <= 0) {
+        *standard_error = 0;
+        return 0;
+    }
+
+    // Every accumulator sees the same weights; take n_eff from one of them
+    const Welford* w = &s->pain_reduction;
+    double n_eff = w->sum_w * w->sum_w / w->sum_w2;
+    double p = count / s->weight;
+    *standard_error = sqrt(p * (1 - p) / n_eff);
+    return p;
+}
+
+// ============================================================================
+// PAIRED COMPARISONS
+// ============================================================================
+
+static const char* const PAIRED_METRIC_NAMES[N_PAIRED_METRICS] = {
+    "success", "pain_reduction", "final_tolerance", "discontinuation_day",
+    "adverse_events", "cost", "qaly"
+};
+
+const char* paired_metric_name(PairedMetric m) {
+    return m >= 0 && m < N_PAIRED_METRICS ? PAIRED_METRIC_NAMES[m] : "unknown";
+}
+
+void paired_stats_init(PairedStats* s) {
+    for (int m = 0; m < N_PAIRED_METRICS; m++) {
+        welford_init(&s->metric[m].reference);
+        welford_init(&s->metric[m].candidate);
+        welford_init(&s->metric[m].delta);
+    }
+}
+
+static void paired_metric_values(const CompactOutcome* r, double values[N_PAIRED_METRICS]) {
+    values[PAIRED_SUCCESS] = (r->flags & OUTCOME_SUCCESS) != 0;
+    values[PAIRED_PAIN_REDUCTION] = r->avg_pain_reduction;
+    values[PAIRED_FINAL_TOLERANCE] = r->final_tolerance_level;
+    values[PAIRED_DISCONTINUATION_DAY] = r->discontinuation_day;
+    values[PAIRED_ADVERSE_EVENTS] = r->adverse_event_count;
+    values[PAIRED_COST] = r->total_cost;
+    values[PAIRED_QALY] = r->qaly_gained;
+}
+
+void paired_stats_add(PairedStats* s, const CompactOutcome* reference,
+                      const CompactOutcome* candidate, double weight) {
+    double ref[N_PAIRED_METRICS], cand[N_PAIRED_METRICS];
+    paired_metric_values(reference, ref);
+    paired_metric_values(candidate, cand);
+    for (int m = 0; m < N_PAIRED_METRICS; m++) {
+        welford_add_weighted(&s->metric[m].reference, ref[m], weight);
+        welford_add_weighted(&s->metric[m].candidate, cand[m], weight);
+        welford_add_weighted(&s->metric[m].delta, cand[m] - ref[m], weight);
+    }
+}
+
+void paired_stats_merge(PairedStats* into, const PairedStats* from) {
+    for (int m = 0; m < N_PAIRED_METRICS; m++) {
+        welford_merge(&into->metric[m].reference, &from->metric[m].reference);
+        welford_merge(&into->metric[m].candidate, &from->metric[m].candidate);
+        welford_merge(&into->metric[m].delta, &from->metric[m].delta);
+    }
+}
+
+double paired_standard_error(const PairedWelford* w) {
+    return welford_standard_error(&w->delta);
+}
+
+double unpaired_standard_error(const PairedWelford* w) {
+    double reference = welford_standard_error(&w->reference);
+    double candidate = welford_standard_error(&w->candidate);
+    return sqrt(reference * reference + candidate * candidate);
+}
+
+double paired_variance_reduction(const PairedWelford* w) {
+    double unpaired = welford_variance(&w->reference) + welford_variance(&w->candidate);
+    double paired = welford_variance(&w->delta);
+    if (paired > 0) return unpaired / paired;
+    return unpaired > 0 ? INFINITY : 1.0;
+}
+
+// ============================================================================
+// REPORTING
+// ============================================================================
+
+static double rate(double count, double n) {
+    return n > 0 ? 100.0 * count / n : 0.0;
+}
+
+static void print_distribution(const char* label, const Welford* w, const Histogram* h) {
+    printf("  %-22s %10.4f %10.4f %10.4f %10.4f %10.4f\n", label,
+           w->mean, sqrt(welford_variance(w)),
+           histogram_quantile(h, 0.05), histogram_quantile(h, 0.5), histogram_quantile(h, 0.95));
+}
+
+void outcome_stats_print(const OutcomeStats* s) {
+    printf("\n=========================================================\n");
+    printf("                 STREAMING OUTCOME SUMMARY\n");
+    printf("=========================================================\n");
+    printf("  Patients:             %ld\n", s->n);
+    double n_eff = s->cost.sum_w2 > 0 ? s->cost.sum_w * s->cost.sum_w / s->cost.sum_w2 : 0;
+    if (n_eff < s->n * (1 - 1e-6)) {
+        printf("  Effective sample size: %.0f (unequal sample weights)\n", n_eff);
+    }
+    printf("  Treatment success:    %.2f%%\n", rate(s->n_success, s->weight));
+    printf("  Tolerance developed:  %.2f%%\n", rate(s->n_tolerance, s->weight));
+    printf("  Addiction signs:      %.2f%%\n", rate(s->n_addiction, s->weight));
+    printf("  Withdrawal:           %.2f%%\n", rate(s->n_withdrawal, s->weight));
+
+    printf("\n  Discontinuation reasons:\n");
+    for (int r = 0; r < N_DISCONTINUATION_REASONS; r++) {
+        printf("    %-22s %10.0f (%.2f%%)\n", discontinuation_reason_name(r),
+               s->n_reason[r], rate(s->n_reason[r], s->weight));
+    }
+
+    printf("\n  %-22s %10s %10s %10s %10s %10s\n", "", "mean", "sd", "p5", "median", "p95");
+    print_distribution("Pain reduction", &s->pain_reduction, &s->pain_reduction_hist);
+    print_distribution("Final tolerance", &s->final_tolerance, &s->final_tolerance_hist);
+    print_distribution("Discontinuation day", &s->discontinuation_day, &s->discontinuation_day_hist);
+
+    printf("\n  Adverse events:       %.0f (%.3f per patient)\n",
+           s->total_adverse_events, s->adverse_events.mean);
+    printf("  Total cost:           $%.0f (mean $%.2f, sd $%.2f)\n",
+           s->total_cost, s->cost.mean, sqrt(welford_variance(&s->cost)));
+    printf("  Total QALYs gained:   %.2f (mean %.5f)\n", s->total_qaly, s->qaly.mean);
+    if (s->total_qaly > 0) {
+        printf("  Cost per QALY:        $%.0f\n", s->total_cost / s->total_qaly);
+    }
+}
+
+static void write_welford(FILE* f, const char* name, const Welford* w, int last) {
+    fprintf(f, "    \"%s\": {\"n\": %ld, \"mean\": %.8g, \"sd\": %.8g, \"min\": %.8g, \"max\": %.8g}%s\n",
+            name, w->n, w->mean, sqrt(welford_variance(w)),
+            w->n ? w->min : 0.0, w->n ? w->max : 0.0, last ? "" : ",");
+}
+
+static void write_histogram(FILE* f, const char* name, const Histogram* h, int last) {
+    fprintf(f, "    \"%s\": {\"lo\": %g, \"hi\": %g, \"below\": %.10g, \"above\": %.10g, \"bins\": [",
+            name, h->lo, h->hi, h->below, h->above);
+    for (int b = 0; b < STATS_HISTOGRAM_BINS; b++) {
+        fprintf(f, "%.10g%s", h->bins[b], b + 1 < STATS_HISTOGRAM_BINS ? ", " : "");
+    }
+    fprintf(f, "]}%s\n", last ? "" : ",");
+}
+
+int outcome_stats_save_json(const OutcomeStats* s, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"n\": %ld,\n", s->n);
+    fprintf(f, "  \"weight\": %.10g,\n", s->weight);
+    fprintf(f, "  \"success_rate\": %.8g,\n", rate(s->n_success, s->weight) / 100.0);
+    fprintf(f, "  \"tolerance_rate\": %.8g,\n", rate(s->n_tolerance, s->weight) / 100.0);
+    fprintf(f, "  \"addiction_rate\": %.8g,\n", rate(s->n_addiction, s->weight) / 100.0);
+    fprintf(f, "  \"withdrawal_rate\": %.8g,\n", rate(s->n_withdrawal, s->weight) / 100.0);
+    fprintf(f, "  \"total_cost\": %.10g,\n", s->total_cost);
+    fprintf(f, "  \"total_qaly\": %.10g,\n", s->total_qaly);
+    fprintf(f, "  \"total_adverse_events\": %.10g,\n", s->total_adverse_events);
+
+    fprintf(f, "  \"discontinuation_reasons\": {\n");
+    for (int r = 0; r < N_DISCONTINUATION_REASONS; r++) {
+        fprintf(f, "    \"%s\": %.10g%s\n", discontinuation_reason_name(r), s->n_reason[r],
+                r + 1 < N_DISCONTINUATION_REASONS ? "," : "");
+    }
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"distributions\": {\n");
+    write_welford(f, "pain_reduction", &s->pain_reduction, 0);
+    write_welford(f, "final_tolerance", &s->final_tolerance, 0);
+    write_welford(f, "discontinuation_day", &s->discontinuation_day, 0);
+    write_welford(f, "adverse_events", &s->adverse_events, 0);
+    write_welford(f, "cost", &s->cost, 0);
+    write_welford(f, "qaly", &s->qaly, 1);
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"histograms\": {\n");
+    write_histogram(f, "pain_reduction", &s->pain_reduction_hist, 0);
+    write_histogram(f, "final_tolerance", &s->final_tolerance_hist, 0);
+    write_histogram(f, "discontinuation_day", &s->discontinuation_day_hist, 1);
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+
+    fclose(f);
+    return 0;
+}
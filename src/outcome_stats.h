@@ -0,0 +1,188 @@
+/*
+ * outcome_stats.h - Streaming, mergeable population outcome statistics
+ *
+ * The kernels feed every finished patient into a per-thread OutcomeStats
+ * and the per-thread accumulators are merged at the end, so population
+ * summaries never require the full TreatmentOutcome array. Means and
+ * variances use Welford's update and Chan et al.'s pairwise merge; the
+ * histograms have fixed bins so merging is element-wise addition.
+ *
+ * Every patient enters with its sample weight (1 under simple random
+ * sampling, see population_gen.h), so counts, rates, means and histograms
+ * are weighted estimators of the target population. Standard errors use
+ * Kish's effective sample size (sum w)^2 / sum w^2, which is n for unit
+ * weights.
+ *
+ * Merge order follows thread completion order, so sums can differ from
+ * run to run in the last bits; unit-weight counts are exact.
+ */
+
+#ifndef OUTCOME_STATS_H
+#define OUTCOME_STATS_H
+
+#include "patient_sim.h"
+#include "outcome_record.h"
+
+#define STATS_HISTOGRAM_BINS 64
+
+// ============================================================================
+// ACCUMULATORS
+// ============================================================================
+
+typedef struct {
+    long n;
+    double sum_w;   // Sum of weights (n for unit weights)
+    double sum_w2;  // Sum of squared weights
+    double mean;
+    double m2;      // Weighted sum of squared deviations from the mean
+    double min;
+    double max;
+} Welford;
+
+typedef struct {
+    double lo, hi;  // Bins split [lo, hi) evenly; outliers are counted apart
+    double below, above;  // Weighted counts
+    double bins[STATS_HISTOGRAM_BINS];
+} Histogram;
+
+void welford_init(Welford* w);
+void welford_merge(Welford* into, const Welford* from);
+double welford_variance(const Welford* w);        // Sample variance (n - 1 for unit weights)
+double welford_standard_error(const Welford* w);  // Of the mean
+
+static inline void welford_add_weighted(Welford* w, double x, double weight) {
+    w->n++;
+    w->sum_w += weight;
+    w->sum_w2 += weight * weight;
+    double delta = x - w->mean;
+    w->mean += delta * weight / w->sum_w;
+    w->m2 += weight * delta * (x - w->mean);
+    if (x < w->min) w->min = x;
+    if (x > w->max) w->max = x;
+}
+
+static inline void welford_add(Welford* w, double x) {
+    welford_add_weighted(w, x, 1.0);
+}
+
+void histogram_init(Histogram* h, double lo, double hi);
+void histogram_merge(Histogram* into, const Histogram* from);
+double histogram_quantile(const Histogram* h, double q);  // Interpolated within the bin
+
+// NaN counts as below the range, so bad input never indexes a bin
+static inline void histogram_add(Histogram* h, double x, double weight) {
+    if (!(x >= h->lo)) {
+        h->below += weight;
+    } else if (x >= h->hi) {
+        h->above += weight;
+    } else {
+        int bin = (int)((x - h->lo) / (h->hi - h->lo) * STATS_HISTOGRAM_BINS);
+        h->bins[bin < STATS_HISTOGRAM_BINS ? bin : STATS_HISTOGRAM_BINS - 1] += weight;
+    }
+}
+
+// ============================================================================
+// POPULATION OUTCOME STATISTICS
+// ============================================================================
+
+typedef struct OutcomeStats {
+    long n;              // Simulated patients
+    double weight;       // Population patients they stand for (n for unit weights)
+    double n_success;    // Weighted counts
+    double n_tolerance;
+    double n_addiction;
+    double n_withdrawal;
+    double n_reason[N_DISCONTINUATION_REASONS];
+
+    double total_cost;   // Weighted totals
+    double total_qaly;
+    double total_adverse_events;
+
+    Welford pain_reduction;
+    Welford final_tolerance;
+    Welford discontinuation_day;
+    Welford adverse_events;
+    Welford cost;
+    Welford qaly;
+
+    Histogram pain_reduction_hist;
+    Histogram final_tolerance_hist;
+    Histogram discontinuation_day_hist;
+} OutcomeStats;
+
+void outcome_stats_init(OutcomeStats* s);
+void outcome_stats_add(OutcomeStats* s, const CompactOutcome* outcome, double weight);
+void outcome_stats_merge(OutcomeStats* into, const OutcomeStats* from);
+
+// ============================================================================
+// ENDPOINTS
+// ============================================================================
+
+typedef enum {
+    ENDPOINT_SUCCESS_RATE = 0,
+    ENDPOINT_TOLERANCE_RATE,
+    ENDPOINT_ADDICTION_RATE,
+    ENDPOINT_PAIN_REDUCTION,
+    N_ENDPOINTS
+} Endpoint;
+
+// "success", "tolerance", "addiction", "pain_reduction"
+const char* endpoint_name(Endpoint e);
+int endpoint_from_name(const char* name, Endpoint* e);  // -1 if unknown
+
+// Weighted estimate of endpoint e; *standard_error gets the binomial (rates)
+// or Welford (means) standard error at Kish's effective sample size
+double outcome_stats_endpoint(const OutcomeStats* s, Endpoint e, double* standard_error);
+
+void outcome_stats_print(const OutcomeStats* s);
+int outcome_stats_save_json(const OutcomeStats* s, const char* path);  // 0 on success
+
+// ============================================================================
+// PAIRED COMPARISONS
+// ============================================================================
+
+/*
+ * Per-patient differences between a candidate protocol and the reference
+ * protocol, both simulated on the same patient with the same random
+ * streams (common random numbers). The standard error of the mean delta
+ * is sd(delta)/sqrt(n_eff); the variance-reduction factor compares it with
+ * what two independent runs of the same size would give:
+ *
+ *   VRF = (var(reference) + var(candidate)) / var(delta)
+ *
+ * so a VRF of 10 means independent runs would need 10x the patients to
+ * resolve the same difference.
+ */
+typedef struct {
+    Welford reference;
+    Welford candidate;
+    Welford delta;
+} PairedWelford;
+
+typedef enum {
+    PAIRED_SUCCESS = 0,        // 0/1 indicator; delta mean is the rate difference
+    PAIRED_PAIN_REDUCTION,
+    PAIRED_FINAL_TOLERANCE,
+    PAIRED_DISCONTINUATION_DAY,
+    PAIRED_ADVERSE_EVENTS,
+    PAIRED_COST,
+    PAIRED_QALY,
+    N_PAIRED_METRICS
+} PairedMetric;
+
+typedef struct {
+    PairedWelford metric[N_PAIRED_METRICS];
+} PairedStats;
+
+const char* paired_metric_name(PairedMetric m);
+
+void paired_stats_init(PairedStats* s);
+void paired_stats_add(PairedStats* s, const CompactOutcome* reference,
+                      const CompactOutcome* candidate, double weight);
+void paired_stats_merge(PairedStats* into, const PairedStats* from);
+
+double paired_standard_error(const PairedWelford* w);       // sd(delta)/sqrt(n_eff)
+double unpaired_standard_error(const PairedWelford* w);     // Same n_eff, independent runs
+double paired_variance_reduction(const PairedWelford* w);   // INFINITY if var(delta) is 0
+
+#endif // OUTCOME_STATS_H
@@ -4,182 +4,70 @@
  * SR-17018 + SR-14968 + DPP-26 Protocol
  * 
  * Compile with native optimizations:
- * gcc -O3 -march=native -mtune=native -fopenmp patient_sim.c compound_profiles.c statistics.c -lm -o patient_sim
+ * gcc -O3 -march=native -mtune=native -fopenmp patient_sim.c compound_profiles.c statistics.c \
+ *     population_soa.c population_gen.c alias_table.c batch_kernel.c pk_engine.c sim_rng.c \
+ *     progress.c outcome_stats.c outcome_record.c trace_store.c protocol_list.c adaptive_stopping.c \
+ *     sim_config.c dose_schedule.c config_yaml.c tolerance_model.c \
+ *     withdrawal_model.c population_cache.c chunked_pipeline.c covariate_copula.c \
+ *     -lm -lpthread -o patient_sim
  * 
- * Run: ./patient_sim
- * Thread control: OMP_NUM_THREADS=22 ./patient_sim
+ * Run: ./patient_sim [protocol_config.c]
+ *      (random_seed is read from the protocol file; default 42)
+ * Run size and protocol: ./patient_sim -n 20000 --days 28 --timesteps 48 --doses 16,25,5
+ *      or --protocol-file table.txt --protocol NAME; ./patient_sim --help lists all
+ *      options (sim_config.h). The patient_sim.h macros are the defaults.
+ * Protocol sweep on one shared population: ./patient_sim --sweep table.txt
+ *      or --sweep protocol_config.c for every protocol of the configuration
+ *      (formats in protocol_list.h; add --paired for common-random-number
+ *      deltas against the first protocol of the table)
+ * Thread control: OMP_NUM_THREADS=22 ./patient_sim  or  ./patient_sim --threads 22
+ * Scalar reference kernel: add -DSCALAR_KERNEL to the compile line
+ * Compact outcome records instead of the full array: add -DNO_OUTCOME_ARRAY
+ *   (and -DOUTCOME_TRACE_BITS=16 to keep quantized daily traces)
+ * Variance-reduced populations (batch kernel):
+ *   --sampling random|stratified|lhs|stratified-lhs [--allocation-power P]
+ *   (see population_gen.h; P < 1 oversamples rare strata, default 1)
+ * Two-compartment pharmacokinetics (both kernels): --pk-model two-compartment
+ *   (see pk_engine.h)
+ * Tolerance models of tolerance_models.py (both kernels):
+ *   --tolerance sigmoid,max_factor=2,half_life_days=7  (see tolerance_model.h)
+ * Withdrawal episodes (both kernels): --withdrawal on  (see withdrawal_model.h)
+ * Correlated covariates (Gaussian copula): --covariate-correlation default
+ *   or pairs such as age:renal=-0.6  (see covariate_copula.h)
+ * Reuse populations across runs: --population-cache DIR  (see population_cache.h)
+ * Stop once confidence intervals are tight enough (batch kernel):
+ *   --adaptive 0.005  or  --adaptive success=0.005,pain_reduction=0.01
+ *   (see adaptive_stopping.h; --patients becomes the upper limit)
+ * Bounded memory for very large runs (batch kernel): --chunk 1048576
+ *   (see chunked_pipeline.h; summary statistics only)
  */
 
 #include "patient_sim.h"
+#include "sim_kernel.h"
+#include "population_soa.h"
+#include "population_gen.h"
+#include "population_cache.h"
+#include "batch_kernel.h"
+#include "pk_engine.h"
+#include "sim_rng.h"
+#include "progress.h"
+#include "protocol_list.h"
+#include "adaptive_stopping.h"
+#include "chunked_pipeline.h"
+#include "sim_config.h"
 #include <float.h>
 #include <limits.h>
 
-// ============================================================================
-// GLOBAL STATE
-// ============================================================================
-
-// Thread-local RNG state for parallel execution
-static __thread uint64_t rng_state = 0;
-static __thread int rng_initialized = 0;
-
-// Progress tracking
-static int processed_patients = 0;
-static omp_lock_t progress_lock;
-
-// ============================================================================
-// RANDOM NUMBER GENERATION
-// ============================================================================
-
-uint64_t xorshift64(void) {
-    if (!rng_initialized) {
-        // Initialize with thread ID and time
-        rng_state = (uint64_t)time(NULL) ^ (uint64_t)omp_get_thread_num() ^ 0x123456789ABCDEF0;
-        rng_initialized = 1;
-    }
-    
-    rng_state ^= rng_state << 13;
-    rng_state ^= rng_state >> 7;
-    rng_state ^= rng_state << 17;
-    return rng_state;
-}
-
-float random_uniform(void) {
-    return xorshift64() / (float)UINT64_MAX;
-}
-
-float random_normal(float mean, float stddev) {
-    static __thread int has_spare = 0;
-    static __thread float spare;
-    
-    if (has_spare) {
-        has_spare = 0;
-        return spare * stddev + mean;
-    }
-    
-    has_spare = 1;
-    float u = random_uniform();
-    float v = random_uniform();
-    float mag = stddev * sqrtf(-2.0f * logf(u + FLT_MIN));
-    spare = mag * cosf(2.0f * M_PI * v);
-    return mag * sinf(2.0f * M_PI * v) + mean;
-}
-
-int random_categorical(const float* probs, int n) {
-    float r = random_uniform();
-    float cumsum = 0;
-    for (int i = 0; i < n; i++) {
-        cumsum += probs[i];
-        if (r <= cumsum) return i;
-    }
-    return n - 1;
-}
-
-// ============================================================================
-// POPULATION GENERATION
-// ============================================================================
-
-PatientCharacteristics* generate_population(int n) {
-    PatientCharacteristics* patients = (PatientCharacteristics*)calloc(n, sizeof(PatientCharacteristics));
-    if (!patients) {
-        fprintf(stderr, "Failed to allocate memory for %d patients\n", n);
-        exit(1);
-    }
-    
-    // Distribution parameters
-    const float pain_type_probs[] = {0.2, 0.3, 0.15, 0.2, 0.15};  // 5 pain types
-    const float risk_probs[] = {0.4, 0.35, 0.2, 0.05};  // 4 risk categories
-    const float genetic_probs[] = {0.7, 0.1, 0.15, 0.05};  // 4 metabolizer types
-    
-    #pragma omp parallel for
-    for (int i = 0; i < n; i++) {
-        PatientCharacteristics* p = &patients[i];
-        
-        // Demographics
-        p->patient_id = i;
-        p->age = 18 + (uint8_t)(random_uniform() * 62);  // 18-80 years
-        p->sex = random_uniform() < 0.52 ? 1 : 0;  // 52% female
-        p->weight = clamp(50 + random_normal(25, 15), 40, 150);  // kg
-        p->bmi = clamp(18.5 + random_normal(6, 4), 16, 45);
-        
-        // Pain characteristics
-        p->pain_type = random_categorical(pain_type_probs, 5);
-        p->baseline_pain_score = clamp(4 + random_normal(2.5, 1.5), 1, 10);
-        p->pain_duration_months = 1 + (uint16_t)(random_uniform() * 120);  // 1-120 months
-        
-        // Prior opioid use (30% have prior use)
-        p->prior_opioid_use = random_uniform() < 0.3;
-        p->prior_opioid_dose_mme = p->prior_opioid_use ? random_uniform() * 90 : 0;
-        
-        // Risk factors
-        p->risk_category = random_categorical(risk_probs, 4);
-        p->addiction_history = random_uniform() < 0.1;  // 10%
-        p->mental_health_comorbidity = random_uniform() < 0.25;  // 25%
-        p->respiratory_disease = random_uniform() < 0.12;  // 12%
-        
-        // Organ function
-        p->renal_function = clamp(90 + random_normal(0, 20), 15, 120);  // eGFR
-        p->hepatic_function = clamp(1.0 - (p->age > 60 ? 0.1 : 0) + random_normal(0, 0.1), 0.3, 1.0);
-        
-        // Genetics
-        p->cyp2d6_phenotype = random_categorical(genetic_probs, 4);
-        p->cyp3a4_phenotype = random_categorical(genetic_probs, 4);
-        p->oprm1_variant = random_uniform() < 0.15;  // 15% prevalence
-        p->comt_variant = random_uniform() < 0.25;  // 25% prevalence
-        
-        // Adherence (higher for cancer patients)
-        if (p->pain_type == CHRONIC_CANCER) {
-            p->adherence_probability = clamp(0.85 + random_normal(0, 0.1), 0.5, 1.0);
-        } else {
-            p->adherence_probability = clamp(0.7 + random_normal(0, 0.15), 0.3, 0.95);
-        }
-    }
-    
-    return patients;
-}
-
-void free_population(PatientCharacteristics* patients) {
-    free(patients);
-}
-
 // ============================================================================
 // PHARMACOKINETIC MODELING
 // ============================================================================
 
 float calculate_clearance_factor(const PatientCharacteristics* p) {
-    float cl_factor = 1.0;
-    
-    // Age adjustment
-    if (p->age > 65) {
-        cl_factor *= (1.0 - 0.01 * (p->age - 65));  // 1% reduction per year over 65
-    }
-    
-    // Renal function
-    cl_factor *= p->renal_function / 90.0;
-    
-    // Hepatic function
-    cl_factor *= p->hepatic_function;
-    
-    // Genetic factors
-    switch (p->cyp2d6_phenotype) {
-        case POOR_METABOLIZER:
-            cl_factor *= 0.3;
-            break;
-        case RAPID_METABOLIZER:
-            cl_factor *= 1.5;
-            break;
-        case ULTRA_RAPID_METABOLIZER:
-            cl_factor *= 2.0;
-            break;
-        default:
-            break;
-    }
-    
-    // Weight adjustment
-    cl_factor *= powf(p->weight / 70.0, 0.75);  // Allometric scaling
-    
-    return clamp(cl_factor, 0.2, 3.0);
+    return clearance_factor_from_covariates(p->age, p->renal_function, p->hepatic_function,
+                                            p->cyp2d6_phenotype, p->weight);
 }
 
+// Closed-form single-dose profile; the treatment kernels use the pk_engine.h recurrence
 float calculate_concentration(float dose, float t_half, float bioavail, 
                              float cl_factor, float time_since_dose) {
     // One-compartment model with first-order elimination
@@ -200,68 +88,21 @@ float calculate_concentration(float dose, float t_half, float bioavail,
     return fmaxf(concentration, 0);
 }
 
-// ============================================================================
-// RECEPTOR DYNAMICS
-// ============================================================================
-
-typedef struct {
-    float mu_receptor_activity;
-    float tolerance_level;
-    float beta_arrestin_signal;
-} ReceptorState;
-
-ReceptorState calculate_receptor_dynamics(float sr17018_conc, float sr14968_conc, 
-                                          float dpp26_conc, float tolerance_prev) {
-    ReceptorState state = {0};
-    
-    // SR-17018: Allosteric modulator, prevents tolerance
-    float sr17018_binding = sr17018_conc / (SR17018.ki_allosteric1 + sr17018_conc);
-    float sr17018_effect = sr17018_binding * SR17018.intrinsic_activity * SR17018.g_protein_bias;
-    
-    // SR-14968: High G-protein bias
-    float sr14968_binding = sr14968_conc / (SR14968.ki_allosteric1 + sr14968_conc);
-    float sr14968_effect = sr14968_binding * SR14968.intrinsic_activity * SR14968.g_protein_bias;
-    
-    // DPP-26: Orthosteric agonist
-    float dpp26_binding = dpp26_conc / (DPP26.ki_orthosteric + dpp26_conc);
-    float dpp26_effect = dpp26_binding * DPP26.intrinsic_activity;
-    
-    // Competitive inhibition between SR compounds
-    if (sr17018_binding > 0 && sr14968_binding > 0) {
-        float competition = sr17018_conc / (sr17018_conc + sr14968_conc * 10);
-        sr14968_effect *= (1 - 0.3 * competition);
-    }
-    
-    // Total receptor activation
-    state.mu_receptor_activity = sr17018_effect + sr14968_effect + dpp26_effect;
-    
-    // Apply tolerance
-    state.mu_receptor_activity /= (1 + tolerance_prev);
-    
-    // Î²-arrestin signaling (leads to tolerance/addiction)
-    state.beta_arrestin_signal = dpp26_binding * DPP26.beta_arrestin_bias + 
-                                 sr14968_binding * SR14968.beta_arrestin_bias * 0.1;
-    
-    // Tolerance development
-    float tolerance_rate = DPP26.tolerance_rate * dpp26_binding;
-    
-    // SR-17018 reverses tolerance
-    if (sr17018_binding > 0.3) {
-        tolerance_rate -= sr17018_binding * 0.02;  // Reversal rate
-    }
-    
-    state.tolerance_level = tolerance_prev + tolerance_rate * 0.01;  // Per timestep
-    state.tolerance_level = fmaxf(0, state.tolerance_level);  // Can't go negative
-    
-    return state;
-}
-
 // ============================================================================
 // TREATMENT SIMULATION
 // ============================================================================
 
 TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p, 
                                            const Protocol* protocol) {
+    DoseSchedule schedule;
+    DoseEventTable events;
+    dose_schedule_from_protocol(&schedule, protocol);
+    dose_events_compile(&events, &schedule, sim_timesteps_per_day());  // Fits: one phase
+    return simulate_patient_events(p, &events);
+}
+
+TreatmentOutcome simulate_patient_events(const PatientCharacteristics* p,
+                                         const DoseEventTable* events) {
     TreatmentOutcome outcome = {0};
     outcome.patient_id = p->patient_id;
     
@@ -269,15 +110,24 @@ TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p,
     float cl_factor = calculate_clearance_factor(p);
     
     // Adjust doses for patient factors
-    float sr17018_dose = protocol->sr17018_dose;
-    float sr14968_dose = protocol->sr14968_dose;
-    float dpp26_dose = protocol->dpp26_dose;
+    float dose_scale[PK_N_COMPOUNDS] = {1.0f, 1.0f, 1.0f};
     
     // Dose reduction for elderly or impaired
     if (p->age > 70 || p->renal_function < 30) {
-        dpp26_dose *= 0.75;
+        dose_scale[PK_DPP26] = 0.75f;
     }
     
+    // Per-patient random streams, independent of thread scheduling
+    RngStream ae_rng, adherence_rng;
+    rng_stream_init(&ae_rng, rng_get_seed(), p->patient_id, RNG_STREAM_ADVERSE_EVENTS);
+    rng_stream_init(&adherence_rng, rng_get_seed(), p->patient_id, RNG_STREAM_ADHERENCE);
+    
+    // Adverse events are rare: draw the steps to the next candidate instead
+    // of testing every timestep
+    RngThinning ae_thinning;
+    rng_thinning_init(&ae_thinning, adverse_event_probability_bound());
+    int ae_countdown = rng_thinning_gap(&ae_rng, &ae_thinning);
+    
     // Simulation state
     float tolerance = 0;
     float cumulative_analgesia = 0;
@@ -286,47 +136,50 @@ TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p,
     float total_cost = 0;
     
     // Time tracking
-    int timesteps_per_day = TIMESTEPS_PER_DAY;
+    int days = sim_days();
+    int timesteps_per_day = sim_timesteps_per_day();
     float dt = 24.0 / timesteps_per_day;  // hours per timestep
     
-    // Dosing schedules (hours since last dose)
-    float time_since_sr17018 = 0;
-    float time_since_sr14968 = 0;
-    float time_since_dpp26 = 0;
+    // PK recurrence: decay factors are fixed for the whole treatment
+    PkCoefficients pk[PK_N_COMPOUNDS];
+    PkState pk_state[PK_N_COMPOUNDS] = {{0}};
+    for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+        pk_coefficients_init_formulation(&pk[c], pk_compound_profile(c), cl_factor, dt,
+                                         events->formulation[c], events->release_steps[c]);
+    }
+    
+    // Tolerance model of the run, fixed for the whole treatment
+    ToleranceModel tolerance_model;
+    tolerance_model_init(&tolerance_model, tolerance_config(), dt / 24.0f);
+    const ToleranceKind tolerance_kind = tolerance_model.kind;
+    
+    // Withdrawal is only looked at on day boundaries and at the end
+    const WithdrawalConfig* withdrawal = withdrawal_config();
+    WithdrawalEpisode episode = {0};
     
     // Main simulation loop
-    for (int day = 0; day < SIMULATION_DAYS; day++) {
+    for (int day = 0; day < days; day++) {
         float daily_pain_sum = 0;
         float daily_analgesia_sum = 0;
+        int next_event[PK_N_COMPOUNDS] = {0};
+        int phase = events->phase_of_day[day];
         
         for (int ts = 0; ts < timesteps_per_day; ts++) {
-            float hour = day * 24.0 + ts * dt;
-            
-            // Check dosing schedule
-            if (fmodf(hour, 12.0) < dt) {  // BID for SR-17018
-                time_since_sr17018 = 0;
-            }
-            if (fmodf(hour, 24.0) < dt) {  // QD for SR-14968
-                time_since_sr14968 = 0;
+            // Dose events of this timestep, in compound order
+            for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+                int e = next_event[c];
+                if (e < events->n_events[c] && events->step[c][e] == ts) {
+                    pk_administer(&pk_state[c], &pk[c], events->dose_mg[phase][c][e] * dose_scale[c]);
+                    next_event[c]++;
+                }
             }
-            if (fmodf(hour, 6.0) < dt) {  // Q6H for DPP-26
-                time_since_dpp26 = 0;
-            }
-            
-            // Calculate concentrations
-            float sr17018_conc = calculate_concentration(sr17018_dose, SR17018.t_half, 
-                                                        SR17018.bioavailability, cl_factor, 
-                                                        time_since_sr17018);
-            float sr14968_conc = calculate_concentration(sr14968_dose, SR14968.t_half,
-                                                        SR14968.bioavailability, cl_factor,
-                                                        time_since_sr14968);
-            float dpp26_conc = calculate_concentration(dpp26_dose, DPP26.t_half,
-                                                      DPP26.bioavailability, cl_factor,
-                                                      time_since_dpp26);
             
             // Update receptor dynamics
-            ReceptorState receptor = calculate_receptor_dynamics(sr17018_conc, sr14968_conc,
-                                                                dpp26_conc, tolerance);
+            ReceptorState receptor = calculate_receptor_dynamics(pk_state[PK_SR17018].central,
+                                                                pk_state[PK_SR14968].central,
+                                                                pk_state[PK_DPP26].central,
+                                                                tolerance, tolerance_kind,
+                                                                &tolerance_model);
             tolerance = receptor.tolerance_level;
             max_beta_arrestin = fmaxf(max_beta_arrestin, receptor.beta_arrestin_signal);
             
@@ -334,11 +187,11 @@ TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p,
             float analgesia = receptor.mu_receptor_activity;
             
             // Genetic modulation
-            if (p->oprm1_variant) analgesia *= 0.8;
-            if (p->comt_variant) analgesia *= 1.1;
+            if (p->oprm1_variant) analgesia *= 0.8f;
+            if (p->comt_variant) analgesia *= 1.1f;
             
             // Calculate pain score
-            float pain = p->baseline_pain_score * (1 - analgesia * 0.7);
+            float pain = p->baseline_pain_score * (1 - analgesia * 0.7f);
             pain = clamp(pain, 0, 10);
             
             daily_pain_sum += pain;
@@ -346,14 +199,16 @@ TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p,
             cumulative_analgesia += analgesia;
             
             // Check for adverse events
-            if (random_uniform() < 0.001 * receptor.beta_arrestin_signal) {
-                adverse_events++;
+            if (--ae_countdown == 0) {
+                adverse_events += rng_thinning_accept(&ae_rng, &ae_thinning,
+                        adverse_event_probability(receptor.beta_arrestin_signal));
+                ae_countdown = rng_thinning_gap(&ae_rng, &ae_thinning);
             }
             
-            // Update time
-            time_since_sr17018 += dt;
-            time_since_sr14968 += dt;
-            time_since_dpp26 += dt;
+            // Advance every compartment by one timestep
+            for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+                pk_advance(&pk_state[c], &pk[c]);
+            }
         }
         
         // Record daily averages
@@ -372,7 +227,7 @@ TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p,
         }
         
         // Check adherence
-        if (random_uniform() > p->adherence_probability) {
+        if (rng_uniform(&adherence_rng) > p->adherence_probability) {
             outcome.treatment_success = false;
             outcome.discontinuation_day = day;
             strcpy(outcome.discontinuation_reason, "non_adherence");
@@ -394,64 +249,318 @@ TreatmentOutcome simulate_patient_treatment(const PatientCharacteristics* p,
                 break;
             }
         }
+        
+        if (withdrawal->enabled && day + 1 < days) {
+            withdrawal_day_boundary(withdrawal, &episode, pk_state[PK_DPP26].central,
+                                    pk_state[PK_SR17018].central, tolerance);
+        }
     }
     
-    // Calculate final outcomes
-    outcome.avg_pain_reduction = cumulative_analgesia / (SIMULATION_DAYS * timesteps_per_day);
-    outcome.tolerance_developed = tolerance > TOLERANCE_THRESHOLD;
-    outcome.addiction_signs = max_beta_arrestin > ADDICTION_RISK_THRESHOLD / 100.0;
-    outcome.withdrawal_occurred = false;  // SR-17018 prevents withdrawal
-    outcome.adverse_event_count = adverse_events;
-    outcome.final_tolerance_level = tolerance;
-    outcome.total_cost = total_cost;
-    
-    // QALY calculation
-    float qaly_days = outcome.discontinuation_day > 0 ? outcome.discontinuation_day : SIMULATION_DAYS;
-    outcome.qaly_gained = (qaly_days / DAYS_PER_YEAR) * QALY_UTILITY_GAIN_FACTOR * outcome.avg_pain_reduction;
-    
-    // Success determination
-    if (outcome.discontinuation_day == 0) {
-        outcome.treatment_success = true;
-        outcome.discontinuation_day = SIMULATION_DAYS;
+    if (withdrawal->enabled) {
+        withdrawal_end_of_treatment(withdrawal, &episode, pk_state[PK_SR17018].central, tolerance);
     }
-    
+    finalize_treatment_outcome(&outcome, cumulative_analgesia, tolerance, max_beta_arrestin,
+                               adverse_events, total_cost, episode.occurred);
     return outcome;
 }
 
+void finalize_treatment_outcome(TreatmentOutcome* outcome, float cumulative_analgesia,
+                                float tolerance, float max_beta_arrestin,
+                                int adverse_events, float total_cost, int withdrawal) {
+    CompactOutcome record;
+    outcome_record_finalize(&record, outcome->patient_id,
+                            discontinuation_reason_from_name(outcome->discontinuation_reason),
+                            outcome->discontinuation_day, cumulative_analgesia, tolerance,
+                            max_beta_arrestin, adverse_events, total_cost, withdrawal);
+    outcome_record_apply(&record, outcome);
+}
+
 // ============================================================================
 // PARALLEL SIMULATION
 // ============================================================================
 
+void simulate_population_streaming(const PatientCharacteristics* patients,
+                                   const DoseSchedule* schedule,
+                                   int n_patients,
+                                   const OutcomeSink* sink) {
+    DoseEventTable events;
+    if (dose_events_compile(&events, schedule, sim_timesteps_per_day()) != 0) {
+        fprintf(stderr, "Error: dose schedule needs more than %d dose timesteps per day\n",
+                DOSE_MAX_EVENTS);
+        exit(1);
+    }
+    progress_start(n_patients, 1);
+    
+    #pragma omp parallel
+    {
+        OutcomeStats local;
+        outcome_stats_init(&local);
+        
+        #pragma omp for schedule(dynamic, BATCH_SIZE) nowait
+        for (int i = 0; i < n_patients; i++) {
+            double started = omp_get_wtime();
+            TreatmentOutcome outcome = simulate_patient_events(&patients[i], &events);
+            CompactOutcome record;
+            outcome_record_from_treatment(&record, &outcome);
+            outcome_sink_emit(sink, sink->stats ? &local : NULL, i, &record,
+                              outcome.daily_pain_scores, outcome.analgesia_achieved);
+            progress_add(1);
+            progress_add_busy(omp_get_wtime() - started);
+        }
+        
+        if (sink->stats) {
+            #pragma omp critical
+            outcome_stats_merge(sink->stats, &local);
+        }
+    }
+    
+    progress_stop();
+}
+
 void simulate_population_parallel(const PatientCharacteristics* patients,
                                  const Protocol* protocol,
                                  TreatmentOutcome* outcomes,
                                  int n_patients) {
-    processed_patients = 0;
+    OutcomeSink sink = {.outcomes = outcomes};
+    DoseSchedule schedule;
+    dose_schedule_from_protocol(&schedule, protocol);
+    simulate_population_streaming(patients, &schedule, n_patients, &sink);
+}
+
+// ============================================================================
+// MAIN ENTRY POINT
+// ============================================================================
+
+// Reads the `random_seed:` field of a protocol_config.c-style file
+static uint64_t read_random_seed(const char* path, uint64_t fallback) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Warning: cannot open %s, using default seed\n", path);
+        return fallback;
+    }
     
-    #pragma omp parallel for schedule(dynamic, BATCH_SIZE)
-    for (int i = 0; i < n_patients; i++) {
-        outcomes[i] = simulate_patient_treatment(&patients[i], protocol);
-        
-        // Update progress
-        #pragma omp critical
-        {
-            processed_patients++;
-            if (processed_patients % 1000 == 0) {
-                printf("\rProgress: %d/%d patients (%.1f%%)", 
-                       processed_patients, n_patients, 
-                       100.0 * processed_patients / n_patients);
-                fflush(stdout);
+    char line[256];
+    uint64_t seed = fallback;
+    while (fgets(line, sizeof(line), f)) {
+        const char* field = strstr(line, "random_seed:");
+        if (field) {
+            seed = strtoull(field + strlen("random_seed:"), NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return seed;
+}
+
+static void print_dose_schedule(const DoseSchedule* s) {
+    static const char* const label[PK_N_COMPOUNDS] = {
+        "SR-17018: ", "SR-14968: ", "DPP-26:   "
+    };
+    static const char* const role[PK_N_COMPOUNDS] = {
+        "tolerance protector", "sustained signaling", "safer opioid alternative"
+    };
+    
+    for (int p = 0; p < s->n_phases; p++) {
+        const DosePhase* phase = &s->phase[p];
+        if (s->n_phases > 1) {
+            printf("  From day %d:\n", s->start_day[p]);
+        }
+        for (int c = 0; c < PK_N_COMPOUNDS; c++) {
+            printf("%s  %s", s->n_phases > 1 ? "  " : "", label[c]);
+            if (phase->n_doses[c] == 0) {
+                printf("not given\n");
+                continue;
+            }
+            for (int d = 0; d < phase->n_doses[c]; d++) {
+                printf("%s%.2f mg @ %gh", d ? ", " : "", phase->dose_mg[c][d], phase->hour[c][d]);
             }
+            if (s->formulation[c] != PK_IMMEDIATE_RELEASE) {
+                printf(" %s", pk_formulation_name(s->formulation[c]));
+            }
+            printf(" (%s)\n", role[c]);
         }
     }
-    printf("\rProgress: %d/%d patients (100.0%%)\n", n_patients, n_patients);
 }
 
 // ============================================================================
-// MAIN ENTRY POINT
+// POPULATION
+// ============================================================================
+
+// Population of the run, through the --population-cache directory if given
+static PopulationSoA* run_population(const char* cache_dir, int n, const SamplingPlan* plan) {
+    if (!cache_dir) return generate_population_soa_sampled(n, plan);
+
+    int mapped;
+    PopulationSoA* pop = population_cache_open(cache_dir, n, plan, &mapped);
+    if (pop) printf("  Population %s %s\n", mapped ? "mapped from" : "generated and stored in", cache_dir);
+    return pop;
+}
+
 // ============================================================================
+// PROTOCOL SWEEP
+// ============================================================================
+
+#ifndef SCALAR_KERNEL
+static void save_sweep_csv(const ProtocolList* list, const OutcomeStats* stats, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "protocol,sr17018_dose,sr14968_dose,dpp26_dose,n,success_rate,tolerance_rate,"
+               "addiction_rate,mean_pain_reduction,sd_pain_reduction,mean_discontinuation_day,"
+               "mean_adverse_events,mean_cost,mean_qaly\n");
+    for (int p = 0; p < list->n; p++) {
+        const OutcomeStats* s = &stats[p];
+        double n = s->weight > 0 ? s->weight : 1.0;
+        fprintf(f, "%s,%.4f,%.4f,%.4f,%ld,%.6f,%.6f,%.6f,%.6f,%.6f,%.4f,%.6f,%.4f,%.6f\n",
+                list->names[p], list->protocols[p].sr17018_dose, list->protocols[p].sr14968_dose,
+                list->protocols[p].dpp26_dose, s->n, s->n_success / n, s->n_tolerance / n,
+                s->n_addiction / n, s->pain_reduction.mean, sqrt(welford_variance(&s->pain_reduction)),
+                s->discontinuation_day.mean, s->adverse_events.mean, s->cost.mean, s->qaly.mean);
+    }
+    fclose(f);
+}
+
+static void save_paired_csv(const ProtocolList* list, const PairedStats* paired, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "protocol,reference,metric,n,reference_mean,protocol_mean,mean_delta,"
+               "paired_se,unpaired_se,variance_reduction\n");
+    for (int p = 1; p < list->n; p++) {
+        for (int m = 0; m < N_PAIRED_METRICS; m++) {
+            const PairedWelford* w = &paired[p].metric[m];
+            fprintf(f, "%s,%s,%s,%ld,%.8g,%.8g,%.8g,%.8g,%.8g,%.6g\n", list->names[p],
+                    list->names[0], paired_metric_name(m), w->delta.n, w->reference.mean,
+                    w->candidate.mean, w->delta.mean, paired_standard_error(w),
+                    unpaired_standard_error(w), paired_variance_reduction(w));
+        }
+    }
+    fclose(f);
+}
+
+static void print_paired_summary(const ProtocolList* list, const PairedStats* paired) {
+    static const PairedMetric shown[] = {PAIRED_SUCCESS, PAIRED_PAIN_REDUCTION, PAIRED_COST,
+                                         PAIRED_QALY};
+    const int n_shown = sizeof(shown) / sizeof(shown[0]);
+
+    printf("\nPaired deltas vs %s (common random numbers; delta +/- SE [VRF]):\n",
+           list->names[0]);
+    printf("%-24s", "Protocol");
+    for (int m = 0; m < n_shown; m++) printf(" %32s", paired_metric_name(shown[m]));
+    printf("\n");
+
+    for (int p = 1; p < list->n; p++) {
+        printf("%-24s", list->names[p]);
+        for (int m = 0; m < n_shown; m++) {
+            const PairedWelford* w = &paired[p].metric[shown[m]];
+            double se = paired_standard_error(w);
+            double vrf = paired_variance_reduction(w);
+            // Identical outcomes (e.g. a duplicate of the reference) have no
+            // paired spread to compare against
+            char vrf_text[16] = "  n/a";
+            if (isfinite(vrf) && se > 0) snprintf(vrf_text, sizeof(vrf_text), "%5.1fx", vrf);
+            printf(" %+11.4g +/- %-9.3g [%-6s]", w->delta.mean, se, vrf_text);
+        }
+        printf("\n");
+    }
+    printf("VRF: how many times more patients two independent runs would need\n"
+           "for the same standard error on the delta.\n");
+}
+
+// Evaluates every protocol of the table (or protocol configuration file)
+// on one shared population. With paired set, all protocols replay the same
+// per-patient random streams and are compared patient by patient against
+// the first protocol of the table.
+static int run_protocol_sweep(const char* table_path, int n_patients, int paired,
+                              const SamplingPlan* plan, const char* cache_dir) {
+    ProtocolList list;
+    protocol_list_init(&list);
+    if (protocol_list_load(&list, table_path) != 0) return 1;
+    if (list.n == 0) {
+        fprintf(stderr, "Error: sweep table %s lists no protocols\n", table_path);
+        protocol_list_free(&list);
+        return 1;
+    }
+    printf("Protocol sweep: %d protocols from %s\n\n", list.n, table_path);
+
+    printf("Phase 1: Generating patient population...\n");
+    double start_time = omp_get_wtime();
+    PopulationSoA* population = run_population(cache_dir, n_patients, plan);
+    OutcomeStats* stats = (OutcomeStats*)malloc(list.n * sizeof(OutcomeStats));
+    OutcomeSink* sinks = (OutcomeSink*)calloc(list.n, sizeof(OutcomeSink));
+    PairedStats* paired_stats = paired ? (PairedStats*)malloc(list.n * sizeof(PairedStats)) : NULL;
+    if (!population || !stats || !sinks || (paired && !paired_stats)) {
+        fprintf(stderr, "Failed to allocate memory for the sweep\n");
+        population_soa_destroy(population);
+        free(stats);
+        free(paired_stats);
+        free(sinks);
+        protocol_list_free(&list);
+        return 1;
+    }
+    for (int p = 0; p < list.n; p++) {
+        outcome_stats_init(&stats[p]);
+        sinks[p].stats = &stats[p];
+        sinks[p].weights = population->sample_weight;
+        if (paired_stats) paired_stats_init(&paired_stats[p]);
+    }
+    double gen_time = omp_get_wtime() - start_time;
+    printf("  Population generated in %.2f seconds\n\n", gen_time);
+
+    printf("Phase 2: Running protocol sweep (SIMD batch, %d lanes, %s random numbers)...\n",
+           SIM_LANES, paired ? "common" : "independent");
+    start_time = omp_get_wtime();
+    simulate_population_sweep(population, list.schedules, list.n, sinks, paired_stats);
+    double sim_time = omp_get_wtime() - start_time;
+    printf("  Sweep completed in %.2f seconds\n", sim_time);
+    printf("  Throughput: %.0f patient-protocols/second\n\n", (double)n_patients * list.n / sim_time);
+
+    printf("%-24s %8s %8s %8s %9s %9s %9s %10s\n", "Protocol", "SR-17018", "SR-14968", "DPP-26",
+           "Success%", "Toler.%", "Addict.%", "PainRed.");
+    for (int p = 0; p < list.n; p++) {
+        const OutcomeStats* s = &stats[p];
+        double n = s->weight > 0 ? s->weight : 1.0;
+        printf("%-24s %8.2f %8.2f %8.2f %9.2f %9.2f %9.2f %10.4f\n", list.names[p],
+               list.protocols[p].sr17018_dose, list.protocols[p].sr14968_dose,
+               list.protocols[p].dpp26_dose, 100.0 * s->n_success / n,
+               100.0 * s->n_tolerance / n, 100.0 * s->n_addiction / n, s->pain_reduction.mean);
+    }
+
+    save_sweep_csv(&list, stats, "sweep_summary.csv");
+    if (paired_stats && list.n > 1) {
+        print_paired_summary(&list, paired_stats);
+        save_paired_csv(&list, paired_stats, "sweep_paired.csv");
+        printf("\nâœ“ Paired deltas saved to sweep_paired.csv");
+    }
+    printf("\nâœ“ Sweep complete. Per-protocol statistics saved to sweep_summary.csv\n\n");
+
+    population_soa_destroy(population);
+    free(stats);
+    free(paired_stats);
+    free(sinks);
+    protocol_list_free(&list);
+    return 0;
+}
+#endif
 
 int main(int argc, char** argv) {
+    SimConfig config;
+    sim_config_defaults(&config);
+    int parsed = sim_config_parse(&config, argc, argv);
+    if (parsed != 0) return parsed > 0 ? 0 : 1;
+    if (sim_set_grid(config.days, config.timesteps_per_day) != 0) return 1;
+    pk_set_model(config.pk_model);
+    tolerance_set_config(&config.tolerance);
+    withdrawal_set_config(&config.withdrawal);
+    covariate_copula_set(&config.copula);
+    const int n_patients = config.n_patients;
+    
     // Print header
     printf("\n");
     printf("â•”â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•—\n");
@@ -464,77 +573,252 @@ int main(int argc, char** argv) {
     int max_threads = omp_get_max_threads();
     printf("System Configuration:\n");
     printf("  Max threads available: %d\n", max_threads);
-    printf("  Threads to use: %d\n", max_threads > MAX_THREADS ? MAX_THREADS : max_threads);
-    printf("  Patient population: %d\n", N_PATIENTS);
-    printf("  Simulation duration: %d days\n", SIMULATION_DAYS);
+    int threads = max_threads > config.max_threads ? config.max_threads : max_threads;
+    printf("  Threads to use: %d\n", threads);
+    printf("  Patient population: %d\n", n_patients);
+    printf("  Simulation duration: %d days x %d timesteps\n", sim_days(), sim_timesteps_per_day());
+    printf("  PK model: %s\n", pk_model_name(pk_model()));
+    if (!config.tolerance.per_timestep) {
+        printf("  Tolerance model: %s\n", tolerance_kind_name(config.tolerance.kind));
+    }
+    if (config.withdrawal.enabled) {
+        printf("  Withdrawal: onset after %g days, %g days of follow-up\n",
+               config.withdrawal.onset_delay_days, config.withdrawal.followup_days);
+    }
+    
+    // Counter-based RNG: results depend on the seed only, not on threading
+    uint64_t seed = config.seed;
+    if (!config.seed_given && config.config_path) {
+        seed = read_random_seed(config.config_path, DEFAULT_RANDOM_SEED);
+    }
+    rng_set_seed(seed);
+    printf("  Random seed: %llu\n", (unsigned long long)seed);
+    printf("  Population sampling: %s\n", sampling_mode_name(config.sampling));
+    if (config.copula.enabled) {
+        printf("  Covariate correlation: Gaussian copula over age, weight, BMI, renal, hepatic\n");
+    }
     printf("\n");
     
     // Set thread count
-    omp_set_num_threads(max_threads > MAX_THREADS ? MAX_THREADS : max_threads);
-    omp_init_lock(&progress_lock);
-    
-    // Initialize protocol
-    Protocol protocol = {
-        .sr17018_dose = 16.17f,  // mg BID
-        .sr14968_dose = 25.31f,  // mg QD
-        .dpp26_dose = 5.07f      // mg Q6H (replacing oxycodone)
-    };
+    omp_set_num_threads(threads);
+    
+    const SamplingMode sampling = config.sampling;
+    const char* adaptive_spec = config.adaptive_spec;
+    const char* sweep_path = config.sweep_path;
+    const int chunked = config.chunk_patients > 0;
+    SamplingPlan plan;
+    if (sampling_plan_init(&plan, sampling, config.allocation_power, n_patients) != 0) return 1;
+    const SamplingPlan* population_plan = sampling == SAMPLING_RANDOM ? NULL : &plan;
+    PrecisionTargets targets;
+    precision_targets_init(&targets, n_patients);
+    if (adaptive_spec && precision_targets_parse(&targets, adaptive_spec) != 0) return 1;
+#ifdef SCALAR_KERNEL
+    if (population_plan || adaptive_spec || chunked) {
+        fprintf(stderr, "Error: --sampling, --adaptive and --chunk need the batch kernel "
+                        "(build without -DSCALAR_KERNEL)\n");
+        return 1;
+    }
+#endif
+    if (adaptive_spec && config.population_cache) {
+        fprintf(stderr, "Error: --adaptive generates the population batch by batch; "
+                        "it cannot use --population-cache\n");
+        return 1;
+    }
+    if (adaptive_spec && sweep_path) {
+        fprintf(stderr, "Error: --adaptive runs a single protocol, not a --sweep\n");
+        return 1;
+    }
+    if (chunked && (adaptive_spec || sweep_path || config.population_cache)) {
+        fprintf(stderr, "Error: --chunk streams one protocol over a population it never holds; "
+                        "it cannot be combined with --adaptive, --sweep or --population-cache\n");
+        return 1;
+    }
+    
+    if (config.paired && !sweep_path) {
+        fprintf(stderr, "Error: --paired compares the protocols of a --sweep table\n");
+        return 1;
+    }
+    if (sweep_path) {
+#ifdef SCALAR_KERNEL
+        fprintf(stderr, "Error: --sweep needs the batch kernel (build without -DSCALAR_KERNEL)\n");
+        return 1;
+#else
+        return run_protocol_sweep(sweep_path, n_patients, config.paired, population_plan,
+                                  config.population_cache);
+#endif
+    }
     
-    printf("Protocol Configuration:\n");
-    printf("  SR-17018: %.2f mg BID (tolerance protector)\n", protocol.sr17018_dose);
-    printf("  SR-14968: %.2f mg QD (sustained signaling)\n", protocol.sr14968_dose);
-    printf("  DPP-26:   %.2f mg Q6H (safer opioid alternative)\n", protocol.dpp26_dose);
+    const DoseSchedule* schedule = &config.schedule;
+    
+    printf("Protocol Configuration: %s\n", config.protocol_name);
+    print_dose_schedule(schedule);
     printf("\n");
     
     // Generate patient population
     printf("Phase 1: Generating patient population...\n");
     double start_time = omp_get_wtime();
-    PatientCharacteristics* patients = generate_population(N_PATIENTS);
+#ifdef SCALAR_KERNEL
+    PatientCharacteristics* patients = NULL;
+    if (config.population_cache) {
+        PopulationSoA* cached = run_population(config.population_cache, n_patients, NULL);
+        patients = (PatientCharacteristics*)calloc(n_patients, sizeof(PatientCharacteristics));
+        if (!cached || !patients) {
+            fprintf(stderr, "Failed to allocate memory for %d patients\n", n_patients);
+            return 1;
+        }
+        for (int i = 0; i < n_patients; i++) population_soa_get(cached, i, &patients[i]);
+        population_soa_destroy(cached);
+    } else {
+        patients = generate_population(n_patients);
+    }
+#else
+    // Adaptive runs generate each batch of patients just before simulating
+    // it; chunked runs generate every chunk in the pipeline
+    PopulationSoA* population = chunked ? NULL
+        : adaptive_spec ? population_soa_create(n_patients)
+        : run_population(config.population_cache, n_patients, population_plan);
+    if (!population && !chunked) {
+        fprintf(stderr, "Failed to allocate memory for population columns\n");
+        return 1;
+    }
+#endif
     double gen_time = omp_get_wtime() - start_time;
-    printf("  Population generated in %.2f seconds\n\n", gen_time);
+    if (chunked) {
+        printf("  Population generated chunk by chunk in Phase 2\n\n");
+    } else if (adaptive_spec) {
+        printf("  Population generated batch by batch in Phase 2\n\n");
+    } else {
+        printf("  Population generated in %.2f seconds\n\n", gen_time);
+    }
     
-    // Allocate outcomes
-    TreatmentOutcome* outcomes = (TreatmentOutcome*)calloc(N_PATIENTS, sizeof(TreatmentOutcome));
-    if (!outcomes) {
-        fprintf(stderr, "Failed to allocate memory for outcomes\n");
-        free_population(patients);
-        return 1;
+    // Full TreatmentOutcome records feed the legacy report; -DNO_OUTCOME_ARRAY
+    // keeps 24-byte compact records instead, plus daily traces if
+    // -DOUTCOME_TRACE_BITS=32|16|8 is given
+    OutcomeStats summary;
+    outcome_stats_init(&summary);
+    OutcomeSink sink = {.stats = &summary};
+    float* weights = NULL;  // Copy of the sample weights that outlives the population
+#ifndef SCALAR_KERNEL
+    if ((sampling & SAMPLING_STRATIFIED) && !chunked) {
+        weights = (float*)malloc(n_patients * sizeof(float));
+        if (!weights) {
+            fprintf(stderr, "Failed to allocate memory for sample weights\n");
+            return 1;
+        }
+        sink.weights = population->sample_weight;
+    }
+#endif
+    TreatmentOutcome* outcomes = NULL;
+    CompactOutcome* records = NULL;
+    TraceStore* traces = NULL;
+    // Chunked runs keep no per-patient output, only the summary statistics
+    if (!chunked) {
+#ifndef NO_OUTCOME_ARRAY
+        outcomes = (TreatmentOutcome*)calloc(n_patients, sizeof(TreatmentOutcome));
+        if (!outcomes) {
+            fprintf(stderr, "Failed to allocate memory for outcomes\n");
+            return 1;
+        }
+        sink.outcomes = outcomes;
+#else
+        records = (CompactOutcome*)calloc(n_patients, sizeof(CompactOutcome));
+        if (!records) {
+            fprintf(stderr, "Failed to allocate memory for outcome records\n");
+            return 1;
+        }
+        sink.records = records;
+#ifdef OUTCOME_TRACE_BITS
+        traces = trace_store_create(n_patients, (TraceFormat)OUTCOME_TRACE_BITS);
+        if (!traces) {
+            fprintf(stderr, "Failed to reserve the daily trace store\n");
+            return 1;
+        }
+        sink.traces = traces;
+#endif
+#endif
     }
     
     // Run simulation
+    int n_simulated = n_patients;
     printf("Phase 2: Running Monte Carlo simulation...\n");
     start_time = omp_get_wtime();
-    simulate_population_parallel(patients, &protocol, outcomes, N_PATIENTS);
+#ifdef SCALAR_KERNEL
+    printf("  Kernel: scalar reference\n");
+    simulate_population_streaming(patients, schedule, n_patients, &sink);
+    free_population(patients);
+#else
+    printf("  Kernel: SIMD batch (%d lanes)\n", SIM_LANES);
+    if (chunked) {
+        printf("  Pipeline: chunks of %d patients, generated while the previous one runs\n",
+               config.chunk_patients);
+        if (simulate_population_chunked(n_patients, config.chunk_patients, population_plan,
+                                        schedule, &sink) != 0) {
+            return 1;
+        }
+    } else if (adaptive_spec) {
+        n_simulated = simulate_until_precise(population, population_plan, schedule, &sink, &targets);
+    } else {
+        simulate_population_batched(population, schedule, &sink);
+    }
+    if (weights) memcpy(weights, population->sample_weight, n_simulated * sizeof(float));
+    population_soa_destroy(population);
+#endif
     double sim_time = omp_get_wtime() - start_time;
     printf("  Simulation completed in %.2f seconds\n", sim_time);
-    printf("  Throughput: %.0f patients/second\n\n", N_PATIENTS / sim_time);
+    printf("  Throughput: %.0f patients/second\n\n", n_simulated / sim_time);
     
     // Calculate statistics
     printf("Phase 3: Analyzing results...\n");
-    PopulationStatistics stats = calculate_statistics(outcomes, N_PATIENTS);
-    
-    // Print results
-    print_statistics_report(&stats);
-    print_comparison_table(&stats);
+    PopulationStatistics stats;
+    if (outcomes && weights) {
+        // calculate_statistics() counts every record once, which is biased
+        // for a stratified sample; only the weighted summary is reported
+        printf("  Legacy report skipped: %s sampling needs the weighted summary below\n",
+               sampling_mode_name(sampling));
+    } else if (chunked) {
+        printf("  Legacy report skipped: chunked runs keep only the summary below\n");
+    } else if (outcomes) {
+        stats = calculate_statistics(outcomes, n_simulated);
+        
+        // Print results
+        print_statistics_report(&stats);
+        print_comparison_table(&stats);
+    }
+    outcome_stats_print(&summary);
     
     // Performance summary
     printf("\n=========================================================\n");
     printf("                 COMPUTATIONAL PERFORMANCE\n");
     printf("=========================================================\n");
     printf("  Total runtime:        %.2f seconds\n", gen_time + sim_time);
-    printf("  Patients/second:      %.0f\n", N_PATIENTS / (gen_time + sim_time));
+    printf("  Patients/second:      %.0f\n", n_simulated / (gen_time + sim_time));
     printf("  Core efficiency:      %.1f%%\n", 
-           100.0 * N_PATIENTS / ((gen_time + sim_time) * max_threads * 1000));
+           100.0 * n_simulated / ((gen_time + sim_time) * max_threads * 1000));
+    if (adaptive_spec) {
+        printf("  Patients simulated:   %d of %d (%.1f%%)\n", n_simulated, n_patients,
+               100.0 * n_simulated / n_patients);
+    }
     
     // Save results
     printf("\nSaving results...\n");
-    save_results_csv(outcomes, N_PATIENTS, "dpp26_simulation_results.csv");
-    save_statistics_json(&stats, "population_statistics.json");
+    if (outcomes) {
+        save_results_csv(outcomes, n_simulated, "dpp26_simulation_results.csv");
+        if (!weights) save_statistics_json(&stats, "population_statistics.json");
+    } else if (records) {
+        long lost = traces ? trace_store_failures(traces) : 0;
+        if (lost > 0) {
+            fprintf(stderr, "Warning: the trace store ran out of space for %ld patients; "
+                            "they are saved without daily traces\n", lost);
+        }
+        outcome_records_save_csv(records, traces, weights, n_simulated, "dpp26_simulation_results.csv");
+    }
+    outcome_stats_save_json(&summary, "population_summary.json");
     
     // Cleanup
-    omp_destroy_lock(&progress_lock);
-    free_population(patients);
     free(outcomes);
+    free(records);
+    free(weights);
+    trace_store_destroy(traces);
     
     printf("\nâœ“ Simulation complete. Results saved to CSV and JSON files.\n\n");
     
@@ -14,6 +14,7 @@ import time
 
 from opioid_analysis_tools import CompoundDatabase, CompoundProfile
 from opioid_optimization_framework import ProtocolConfig, PharmacokineticModel
+import native_cohort
 
 
 @dataclass
@@ -310,10 +311,19 @@ class PatientGenerator:
         n_patients: int,
         seed: Optional[int] = 42,
         config: Optional[PatientGenerationConfig] = None,
+        native: bool = False,
     ) -> List[PatientProfile]:
-        """Generate population of virtual patients"""
+        """Generate population of virtual patients
+
+        native: draw the cohort with the C generator (native_cohort.py,
+        which must be built). Native and Python cohorts share
+        distributions, not individual draws, so a seed only reproduces a
+        cohort with the same generator.
+        """
         cfg = config or PatientGenerationConfig()
         total = cfg.population_size or n_patients
+        if native:
+            return native_cohort.generate_cohort(total, seed, cfg).to_profiles()
         return [cls.generate_patient(i, seed, cfg) for i in range(total)]
 
 
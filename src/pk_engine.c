@@ -0,0 +1,161 @@
+/*
+ * pk_engine.c - Recurrence-based pharmacokinetic engine
+ */
+
+#include "pk_engine.h"
+
+static PkModel run_model = PK_ONE_COMPARTMENT;
+
+// k12 and k21 (1/h): moderate, compound-specific tissue distribution
+static const PkDistribution compound_distribution[PK_N_COMPOUNDS] = {
+    {0.40f, 0.25f},  // SR-17018
+    {0.30f, 0.20f},  // SR-14968
+    {0.50f, 0.35f}   // DPP-26
+};
+
+void pk_set_model(PkModel model) {
+    run_model = model;
+}
+
+PkModel pk_model(void) {
+    return run_model;
+}
+
+int pk_model_from_name(const char* name, PkModel* model) {
+    if (strcmp(name, "one-compartment") == 0) {
+        *model = PK_ONE_COMPARTMENT;
+    } else if (strcmp(name, "two-compartment") == 0) {
+        *model = PK_TWO_COMPARTMENT;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* pk_model_name(PkModel model) {
+    return model == PK_TWO_COMPARTMENT ? "two-compartment" : "one-compartment";
+}
+
+const PkDistribution* pk_compound_distribution(PkCompound compound) {
+    return &compound_distribution[compound < PK_N_COMPOUNDS ? compound : PK_DPP26];
+}
+
+// Inverse of pk_compound_profile()
+static PkCompound compound_of_profile(const CompoundProfile* compound) {
+    if (compound == &SR17018) return PK_SR17018;
+    if (compound == &SR14968) return PK_SR14968;
+    return PK_DPP26;
+}
+
+// Gut input reaching a mode decaying at rate r over one step:
+// integral over [0, dt] of exp(-r (dt - s)) exp(-ka s) ds
+static double mode_input(double r, double ka, double dt) {
+    if (fabs(ka - r) < 1e-9) return dt * exp(-ka * dt);
+    return (exp(-r * dt) - exp(-ka * dt)) / (ka - r);
+}
+
+// Step matrix of the central/peripheral system. B = [[-(ke+k12), k21],
+// [k12, -k21]] has eigenvalues -alpha and -beta, so by Sylvester's formula
+// exp(B dt) = (exp(-beta dt) (B + alpha I) - exp(-alpha dt) (B + beta I)) / (alpha - beta),
+// and the gut input (ka, 0) decomposes the same way. alpha > beta whenever k12 > 0.
+static void two_compartment_init(PkCoefficients* c, double ke, double ka, double k12,
+                                 double k21, double dt) {
+    double sum = ke + k12 + k21;
+    double root = sqrt(sum * sum - 4.0 * ke * k21);
+    double alpha = 0.5 * (sum + root);
+    double beta = 0.5 * (sum - root);
+    double ea = exp(-alpha * dt), eb = exp(-beta * dt);
+    double wa = mode_input(alpha, ka, dt), wb = mode_input(beta, ka, dt);
+    double b_cc = -(ke + k12), b_pp = -k21;
+
+    c->model = PK_TWO_COMPARTMENT;
+    c->decay_e = (float)((eb * (b_cc + alpha) - ea * (b_cc + beta)) / root);
+    c->from_peripheral = (float)(k21 * (eb - ea) / root);
+    c->to_peripheral = (float)(k12 * (eb - ea) / root);
+    c->decay_p = (float)((eb * (b_pp + alpha) - ea * (b_pp + beta)) / root);
+    c->transfer = (float)(ka * (wb * (b_cc + alpha) - wa * (b_cc + beta)) / root);
+    c->transfer_p = (float)(ka * k12 * (wb - wa) / root);
+}
+
+void pk_coefficients_init(PkCoefficients* c, const CompoundProfile* compound,
+                          float cl_factor, float dt) {
+    pk_coefficients_init_formulation(c, compound, cl_factor, dt, PK_IMMEDIATE_RELEASE, 1.0f);
+}
+
+void pk_coefficients_init_formulation(PkCoefficients* c, const CompoundProfile* compound,
+                                      float cl_factor, float dt, PkFormulation formulation,
+                                      float release_steps) {
+    float ke = 0.693f / (compound->t_half / cl_factor);  // Adjusted elimination constant
+    float ka = formulation == PK_SUSTAINED_RELEASE ? PK_SUSTAINED_ABSORPTION_RATE
+                                                   : PK_ABSORPTION_RATE;
+
+    c->decay_e = expf(-ke * dt);
+    c->decay_a = expf(-ka * dt);
+
+    // ka == ke is the degenerate case of the Bateman function
+    if (fabsf(ka - ke) > 1e-6f) {
+        c->transfer = ka / (ka - ke) * (c->decay_e - c->decay_a);
+    } else {
+        c->transfer = ka * dt * c->decay_e;
+    }
+
+    c->model = PK_ONE_COMPARTMENT;
+    c->from_peripheral = 0;
+    c->to_peripheral = 0;
+    c->decay_p = 0;
+    c->transfer_p = 0;
+    const PkDistribution* distribution = pk_compound_distribution(compound_of_profile(compound));
+    if (run_model == PK_TWO_COMPARTMENT && distribution->k12 > 0) {
+        two_compartment_init(c, ke, ka, distribution->k12, distribution->k21, dt);
+    }
+
+    if (compound->bioavailability < 1.0) {
+        // Oral administration
+        c->to_gut = compound->bioavailability;
+        c->to_central = 0;
+    } else {
+        // IV administration
+        c->to_gut = 0;
+        c->to_central = 1.0f;
+    }
+
+    // Zero-order release: the oral fraction goes through the depot instead
+    c->to_depot = 0;
+    c->release = 0;
+    if (formulation == PK_ZERO_ORDER_RELEASE && c->to_gut > 0) {
+        c->to_depot = c->to_gut;
+        c->to_gut = 0;
+        c->release = c->to_depot / fmaxf(release_steps, 1.0f);
+    }
+}
+
+int pk_formulation_from_name(const char* name, PkFormulation* formulation) {
+    if (strcmp(name, "immediate_release") == 0) {
+        *formulation = PK_IMMEDIATE_RELEASE;
+    } else if (strcmp(name, "sustained_release") == 0) {
+        *formulation = PK_SUSTAINED_RELEASE;
+    } else if (strcmp(name, "extended_release") == 0 || strcmp(name, "zero_order") == 0) {
+        *formulation = PK_ZERO_ORDER_RELEASE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* pk_formulation_name(PkFormulation formulation) {
+    static const char* const names[PK_N_FORMULATIONS] = {
+        "immediate_release", "sustained_release", "extended_release"
+    };
+    return formulation < PK_N_FORMULATIONS ? names[formulation] : "unknown";
+}
+
+const CompoundProfile* pk_compound_profile(PkCompound compound) {
+    switch (compound) {
+        case PK_SR17018:
+            return &SR17018;
+        case PK_SR14968:
+            return &SR14968;
+        default:
+            return &DPP26;
+    }
+}
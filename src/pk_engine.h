@@ -0,0 +1,173 @@
+/*
+ * pk_engine.h - Recurrence-based pharmacokinetic engine
+ *
+ * Each compound is a gut (absorption) compartment feeding a central
+ * compartment with first-order elimination. Over one timestep dt the
+ * exact solution of that linear system is
+ *
+ *   gut'     = gut * exp(-ka*dt)
+ *   central' = central * exp(-ke*dt) + gut * ka/(ka-ke) * (exp(-ke*dt) - exp(-ka*dt))
+ *
+ * so the decay factors are computed once per patient and every timestep
+ * is two multiply-adds. A dose is a bolus added to gut (oral) or central
+ * (IV), which makes repeated doses superpose correctly instead of resetting
+ * the curve at each administration.
+ *
+ * The two-compartment model adds a peripheral compartment exchanging with
+ * central at rates k12 (central -> peripheral) and k21 (back). Central and
+ * peripheral then decay biexponentially with the hybrid rates alpha and
+ * beta, the roots of x^2 - (ke+k12+k21) x + ke*k21. The matrix exponential
+ * of the (gut, central, peripheral) system over dt is still computed once
+ * per patient, so a timestep is
+ *
+ *   central'    = central * m_cc + peripheral * m_cp + gut * transfer
+ *   peripheral' = central * m_pc + peripheral * m_pp + gut * transfer_p
+ *
+ * where m = exp(B*dt) for the central/peripheral block B and the gut terms
+ * integrate the absorbed input against it. ke stays the elimination rate
+ * from central. The model is a run setting (pk_set_model); the rate
+ * constants k12 and k21 are per compound (pk_compound_distribution).
+ *
+ * Oral formulations differ only in how a dose reaches gut:
+ *   - immediate release: the whole dose at once, ka = PK_ABSORPTION_RATE
+ *   - sustained release: the whole dose at once, but absorbed with the
+ *     slower ka = PK_SUSTAINED_ABSORPTION_RATE
+ *   - zero-order (extended) release: the dose enters a depot that releases
+ *     into gut at a constant rate over the release period, then is absorbed
+ *     like an immediate-release dose
+ */
+
+#ifndef PK_ENGINE_H
+#define PK_ENGINE_H
+
+#include "patient_sim.h"
+
+#define PK_ABSORPTION_RATE 2.0f             // ka for oral formulations (1/h)
+#define PK_SUSTAINED_ABSORPTION_RATE 0.3f   // ka for sustained-release formulations (1/h)
+
+typedef enum {
+    PK_SR17018 = 0,
+    PK_SR14968,
+    PK_DPP26,
+    PK_N_COMPOUNDS
+} PkCompound;
+
+typedef enum {
+    PK_ONE_COMPARTMENT = 0,
+    PK_TWO_COMPARTMENT
+} PkModel;
+
+typedef enum {
+    PK_IMMEDIATE_RELEASE = 0,
+    PK_SUSTAINED_RELEASE,
+    PK_ZERO_ORDER_RELEASE,
+    PK_N_FORMULATIONS
+} PkFormulation;
+
+// Intercompartmental rate constants of the two-compartment model (1/h)
+typedef struct {
+    float k12;
+    float k21;
+} PkDistribution;
+
+typedef struct {
+    float decay_e;     // exp(-ke*dt); central -> central (m_cc) in two compartments
+    float decay_a;     // exp(-ka*dt)
+    float transfer;    // gut -> central gain over one step
+    float to_gut;      // Fraction of a dose entering gut (bioavailability if oral)
+    float to_central;  // Fraction of a dose entering central directly (IV)
+    float to_depot;    // Fraction of a dose entering the zero-order release depot
+    float release;     // Depot release per step, as a fraction of the dose
+
+    // Two-compartment terms; all 0 for the one-compartment model
+    PkModel model;
+    float from_peripheral;  // m_cp
+    float to_peripheral;    // m_pc
+    float decay_p;          // m_pp
+    float transfer_p;       // gut -> peripheral gain over one step
+} PkCoefficients;
+
+typedef struct {
+    float gut;
+    float central;
+    float peripheral;
+    float depot;
+    float release_rate;  // Amount released from depot per step
+} PkState;
+
+// Compartment model of the run, read by the coefficient setup; default
+// PK_ONE_COMPARTMENT. Set it before simulating.
+void pk_set_model(PkModel model);
+PkModel pk_model(void);
+
+// "one-compartment" or "two-compartment"; returns 0, or -1 if the name is
+// not recognized
+int pk_model_from_name(const char* name, PkModel* model);
+const char* pk_model_name(PkModel model);
+
+const PkDistribution* pk_compound_distribution(PkCompound compound);
+
+// Per-patient setup for the run's model; the only place transcendental
+// functions are evaluated
+void pk_coefficients_init(PkCoefficients* c, const CompoundProfile* compound,
+                          float cl_factor, float dt);
+
+// Same for a formulation; release_steps is the zero-order release period
+// in timesteps and is ignored by the first-order formulations
+void pk_coefficients_init_formulation(PkCoefficients* c, const CompoundProfile* compound,
+                                      float cl_factor, float dt, PkFormulation formulation,
+                                      float release_steps);
+
+// "immediate_release", "sustained_release" or "extended_release" (zero-order);
+// returns 0, or -1 if the name is not recognized
+int pk_formulation_from_name(const char* name, PkFormulation* formulation);
+const char* pk_formulation_name(PkFormulation formulation);
+
+const CompoundProfile* pk_compound_profile(PkCompound compound);
+
+static inline void pk_administer(PkState* s, const PkCoefficients* c, float dose) {
+    s->gut += dose * c->to_gut;
+    s->central += dose * c->to_central;
+    if (c->to_depot > 0 && dose > 0) {
+        s->depot += dose * c->to_depot;
+        s->release_rate = dose * c->release;
+    }
+}
+
+static inline float pk_step_central(float central, float gut, float decay_e, float transfer) {
+    return central * decay_e + gut * transfer;
+}
+
+// Two-compartment step; both take the amounts at the start of the step
+static inline float pk_step_central2(float central, float peripheral, float gut, float decay_e,
+                                     float from_peripheral, float transfer) {
+    return central * decay_e + peripheral * from_peripheral + gut * transfer;
+}
+
+static inline float pk_step_peripheral(float central, float peripheral, float gut,
+                                       float to_peripheral, float decay_p, float transfer_p) {
+    return central * to_peripheral + peripheral * decay_p + gut * transfer_p;
+}
+
+// Moves this step's zero-order release from depot to gut
+static inline float pk_release_step(float depot, float release_rate) {
+    return depot < release_rate ? depot : release_rate;
+}
+
+static inline void pk_advance(PkState* s, const PkCoefficients* c) {
+    float released = pk_release_step(s->depot, s->release_rate);
+    s->depot -= released;
+    s->gut += released;
+    if (c->model == PK_TWO_COMPARTMENT) {
+        float central = s->central;
+        s->central = pk_step_central2(central, s->peripheral, s->gut, c->decay_e,
+                                      c->from_peripheral, c->transfer);
+        s->peripheral = pk_step_peripheral(central, s->peripheral, s->gut, c->to_peripheral,
+                                           c->decay_p, c->transfer_p);
+    } else {
+        s->central = pk_step_central(s->central, s->gut, c->decay_e, c->transfer);
+    }
+    s->gut *= c->decay_a;
+}
+
+#endif // PK_ENGINE_H
@@ -0,0 +1,171 @@
+/*
+ * population_cache.c - Memory-mapped population files
+ */
+
+#include "population_cache.h"
+#include "covariate_copula.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// KEYS
+// ============================================================================
+
+// FNV-1a, 64 bit
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+uint64_t population_cache_key(int n, uint64_t seed, const SamplingPlan* plan) {
+    const uint32_t version = POPULATION_FILE_VERSION;
+    const int32_t size = n;
+    const int32_t sampling = plan ? (int32_t)plan->mode : SAMPLING_RANDOM;
+
+    uint64_t h = 0xCBF29CE484222325ull;
+    h = hash_bytes(h, &version, sizeof(version));
+    h = hash_bytes(h, &size, sizeof(size));
+    h = hash_bytes(h, &seed, sizeof(seed));
+    h = hash_bytes(h, &sampling, sizeof(sampling));
+    // The allocation power only reaches the population through the stratum
+    // boundaries, so those identify the allocation
+    if (sampling & SAMPLING_STRATIFIED) {
+        h = hash_bytes(h, plan->stratum_start, sizeof(plan->stratum_start));
+    }
+    // Populations without a copula keep the keys they had before it existed
+    const CovariateCopula* copula = covariate_copula();
+    if (copula->enabled) {
+        h = hash_bytes(h, copula->correlation, sizeof(copula->correlation));
+    }
+    return h;
+}
+
+int population_cache_path(char* path, size_t size, const char* dir, uint64_t key) {
+    int written = snprintf(path, size, "%s/population-%016llx.soa", dir, (unsigned long long)key);
+    return written >= 0 && (size_t)written < size ? 0 : -1;
+}
+
+// ============================================================================
+// WRITING
+// ============================================================================
+
+int population_cache_write(const PopulationSoA* pop, const char* path, uint64_t seed,
+                           const SamplingPlan* plan) {
+    char header_page[POPULATION_FILE_HEADER_BYTES] = {0};
+    PopulationFileHeader header = {
+        .version = POPULATION_FILE_VERSION,
+        .byte_order = POPULATION_FILE_BYTE_ORDER,
+        .key = population_cache_key(pop->n, seed, plan),
+        .seed = seed,
+        .n = pop->n,
+        .capacity = pop->capacity,
+        .sampling = plan ? (int32_t)plan->mode : SAMPLING_RANDOM,
+        .header_bytes = POPULATION_FILE_HEADER_BYTES,
+        .block_bytes = population_soa_block_bytes(pop->capacity)
+    };
+    memcpy(header.magic, POPULATION_FILE_MAGIC, sizeof(header.magic));
+
+    char tmp_path[4096];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%ld", path, (long)getpid()) >= (int)sizeof(tmp_path)) {
+        fprintf(stderr, "Error: population file path too long: %s\n", path);
+        return -1;
+    }
+
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "Error: cannot create population file %s: %s\n", tmp_path, strerror(errno));
+        return -1;
+    }
+    memcpy(header_page, &header, sizeof(header));
+    int ok = fwrite(header_page, 1, sizeof(header_page), f) == sizeof(header_page) &&
+             fwrite(pop->block, 1, header.block_bytes, f) == header.block_bytes;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Error: cannot write population file %s: %s\n", path, strerror(errno));
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// MAPPING
+// ============================================================================
+
+// Whether a mapped file of file_bytes is a valid population file for key
+static int header_valid(const PopulationFileHeader* h, size_t file_bytes, uint64_t key) {
+    if (memcmp(h->magic, POPULATION_FILE_MAGIC, sizeof(h->magic)) != 0) return 0;
+    if (h->version != POPULATION_FILE_VERSION || h->byte_order != POPULATION_FILE_BYTE_ORDER) return 0;
+    if (h->key != key || h->header_bytes != POPULATION_FILE_HEADER_BYTES) return 0;
+    if (h->n < 0 || h->capacity != population_soa_capacity(h->n)) return 0;
+    if (h->block_bytes != population_soa_block_bytes(h->capacity)) return 0;
+    return file_bytes == h->header_bytes + h->block_bytes;
+}
+
+PopulationSoA* population_cache_map(const char* path, uint64_t key) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Error: cannot open population file %s: %s\n", path, strerror(errno));
+        }
+        return NULL;
+    }
+
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(PopulationFileHeader)) {
+        mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);  // The mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Error: cannot map population file %s\n", path);
+        return NULL;
+    }
+
+    size_t bytes = (size_t)st.st_size;
+    const PopulationFileHeader* header = (const PopulationFileHeader*)mapping;
+    PopulationSoA* pop = header_valid(header, bytes, key)
+                             ? (PopulationSoA*)calloc(1, sizeof(PopulationSoA))
+                             : NULL;
+    if (!pop) {
+        fprintf(stderr, "Error: %s is not a population file for this cohort\n", path);
+        munmap(mapping, bytes);
+        return NULL;
+    }
+
+    population_soa_bind(pop, (char*)mapping + header->header_bytes, header->n, header->capacity);
+    pop->mapping = mapping;
+    pop->mapping_bytes = bytes;
+    return pop;
+}
+
+// ============================================================================
+// CACHE
+// ============================================================================
+
+PopulationSoA* population_cache_open(const char* dir, int n, const SamplingPlan* plan,
+                                     int* mapped) {
+    uint64_t seed = rng_get_seed();
+    uint64_t key = population_cache_key(n, seed, plan);
+    char path[4096];
+    if (population_cache_path(path, sizeof(path), dir, key) != 0) {
+        fprintf(stderr, "Error: population cache directory path too long: %s\n", dir);
+        *mapped = 0;
+        return generate_population_soa_sampled(n, plan);
+    }
+
+    PopulationSoA* pop = population_cache_map(path, key);
+    *mapped = pop != NULL;
+    if (pop) return pop;
+
+    pop = generate_population_soa_sampled(n, plan);
+    if (pop) population_cache_write(pop, path, seed, plan);
+    return pop;
+}
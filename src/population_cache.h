@@ -0,0 +1,78 @@
+/*
+ * population_cache.h - Memory-mapped population files
+ *
+ * A generated population is a pure function of its size, the run seed and
+ * the sampling plan (population_gen.h), so repeated studies on the same
+ * cohort can reuse it. A population file holds the PopulationSoA column
+ * block byte for byte behind a one-page header; opening one is a single
+ * read-only shared mmap(), with no parsing, and concurrent processes on
+ * the same cohort share its pages.
+ *
+ * File layout (native byte order, checked through byte_order):
+ *   0                      PopulationFileHeader, zero-padded to
+ *                          POPULATION_FILE_HEADER_BYTES
+ *   header_bytes           column block, population_soa_block_bytes(capacity)
+ *                          bytes laid out as population_soa_bind() expects;
+ *                          page alignment keeps every column SOA_ALIGNMENT
+ *                          aligned
+ *
+ * Files are named by their key (population_cache_key), a hash of the cohort:
+ * format version, size, seed, sampling mode, stratum allocation and the
+ * covariate correlations (covariate_copula.h). Bump
+ * POPULATION_FILE_VERSION whenever population_gen.c changes the covariates
+ * it draws, so stale files stop matching.
+ */
+
+#ifndef POPULATION_CACHE_H
+#define POPULATION_CACHE_H
+
+#include "patient_sim.h"
+#include "population_soa.h"
+#include "population_gen.h"
+
+#define POPULATION_FILE_MAGIC "ZPPOPSOA"
+#define POPULATION_FILE_VERSION 2
+#define POPULATION_FILE_HEADER_BYTES 4096
+#define POPULATION_FILE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t key;
+    uint64_t seed;
+    int32_t n;
+    int32_t capacity;
+    int32_t sampling;        // SamplingMode
+    uint32_t header_bytes;
+    uint64_t block_bytes;
+} PopulationFileHeader;
+
+// Cohort key of n patients under the run seed and covariate copula; plan
+// NULL is simple random sampling
+uint64_t population_cache_key(int n, uint64_t seed, const SamplingPlan* plan);
+
+// DIR/population-<key>.soa; returns 0, or -1 if it does not fit
+int population_cache_path(char* path, size_t size, const char* dir, uint64_t key);
+
+// Writes pop, generated under seed and plan, as a population file. The
+// file is written next to path and renamed into place, so readers never
+// see a partial file. Returns 0, or -1 with a message.
+int population_cache_write(const PopulationSoA* pop, const char* path, uint64_t seed,
+                           const SamplingPlan* plan);
+
+// Maps a population file read-only; population_soa_destroy() unmaps it.
+// Returns NULL if the file does not exist, or with a message if it is not
+// a valid population file for key.
+PopulationSoA* population_cache_map(const char* path, uint64_t key);
+
+/*
+ * Population of n patients under the run seed and plan from the cache
+ * directory dir: mapped if the cohort's file exists, otherwise generated
+ * and written for the next run (a failed write only costs the reuse).
+ * *mapped tells which happened. Returns NULL on allocation failure.
+ */
+PopulationSoA* population_cache_open(const char* dir, int n, const SamplingPlan* plan,
+                                     int* mapped);
+
+#endif // POPULATION_CACHE_H
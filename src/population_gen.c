@@ -0,0 +1,387 @@
+/*
+ * population_gen.c - Columnar patient population generation
+ */
+
+#include "population_gen.h"
+#include "alias_table.h"
+#include "covariate_copula.h"
+#include "sim_rng.h"
+#include "simd_math.h"
+
+// ============================================================================
+// DISTRIBUTIONS
+// ============================================================================
+
+static const float pain_type_probs[] = {0.2, 0.3, 0.15, 0.2, 0.15};  // 5 pain types
+static const float risk_probs[] = {0.4, 0.35, 0.2, 0.05};  // 4 risk categories
+static const float genetic_probs[] = {0.7, 0.1, 0.15, 0.05};  // 4 metabolizer types
+
+// ============================================================================
+// BLOCK GENERATION
+// ============================================================================
+
+enum {
+    U_AGE, U_SEX, U_PAIN_TYPE, U_PAIN_DURATION,
+    U_PRIOR_USE, U_PRIOR_DOSE, U_RISK, U_ADDICTION,
+    U_MENTAL_HEALTH, U_RESPIRATORY, U_CYP2D6, U_CYP3A4,
+    U_OPRM1, U_COMT, U_SPARE0, U_SPARE1,
+    N_UNIFORM_COLUMNS
+};
+
+enum {
+    Z_WEIGHT, Z_BMI, Z_BASELINE_PAIN, Z_RENAL, Z_HEPATIC, Z_ADHERENCE,
+    N_NORMAL_COLUMNS
+};
+
+#define UNIFORM_BLOCK_BASE 0
+#define NORMAL_BLOCK_BASE (N_UNIFORM_COLUMNS / 4)
+#define LHS_JITTER_BLOCK_BASE (NORMAL_BLOCK_BASE + N_NORMAL_COLUMNS / 2)
+
+// Uniform columns that are Latin-hypercube sampled; the categorical ones
+// are covered by stratification instead
+static const int lhs_uniform_columns[] = {
+    U_AGE, U_SEX, U_PAIN_DURATION, U_PRIOR_USE, U_PRIOR_DOSE,
+    U_ADDICTION, U_MENTAL_HEALTH, U_RESPIRATORY, U_OPRM1, U_COMT
+};
+#define N_LHS_UNIFORM_COLUMNS (int)(sizeof(lhs_uniform_columns) / sizeof(lhs_uniform_columns[0]))
+
+_Static_assert(N_LHS_UNIFORM_COLUMNS + N_NORMAL_COLUMNS == SAMPLING_LHS_COLUMNS,
+               "SAMPLING_LHS_COLUMNS must cover every non-categorical column");
+
+// Acklam's rational approximation of the standard normal quantile
+// (relative error below 1.2e-9), for p in (0, 1)
+static double normal_quantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                               -2.759285104469687e+02, 1.383577518672690e+02,
+                               -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                               -1.556989798598866e+02, 6.680131188771972e+01,
+                               -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                               -2.400758277161838e+00, -2.549732539343734e+00,
+                               4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                               2.445134137142996e+00, 3.754408661907416e+00};
+    const double p_low = 0.02425;
+
+    if (p < p_low || p > 1 - p_low) {
+        double q = sqrt(-2 * log(p < p_low ? p : 1 - p));
+        double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                   ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+        return p < p_low ? x : -x;
+    }
+
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+// Replaces the independent draws of the non-categorical columns by
+// Latin-hypercube draws: covariate d of patient i falls in cell
+// permutation_d(i) of n, at the patient's own uniform offset inside it
+static void apply_latin_hypercube(const SamplingPlan* plan, const RngBank* bank, int first, int n,
+                                  float u[][POPULATION_GEN_BLOCK], float z[][POPULATION_GEN_BLOCK]) {
+    float jitter[N_NORMAL_COLUMNS + 2][POPULATION_GEN_BLOCK] __attribute__((aligned(SOA_ALIGNMENT)));
+    rng_bank_uniform(bank, LHS_JITTER_BLOCK_BASE, jitter[0], jitter[1], jitter[2], jitter[3]);
+    rng_bank_uniform(bank, LHS_JITTER_BLOCK_BASE + 1, jitter[4], jitter[5], jitter[6], jitter[7]);
+
+    const double inv_n = 1.0 / plan->n;
+    for (int j = 0; j < n; j++) {
+        uint32_t i = (uint32_t)(first + j);
+        for (int d = 0; d < N_LHS_UNIFORM_COLUMNS; d++) {
+            float* col = u[lhs_uniform_columns[d]];
+            col[j] = (float)((rng_permute(&plan->lhs[d], i) + col[j]) * inv_n);
+        }
+        for (int d = 0; d < N_NORMAL_COLUMNS; d++) {
+            uint32_t cell = rng_permute(&plan->lhs[N_LHS_UNIFORM_COLUMNS + d], i);
+            z[d][j] = (float)normal_quantile((cell + jitter[d][j]) * inv_n);
+        }
+    }
+}
+
+// Gaussian copula over age and the correlated normal columns: age enters
+// as the normal quantile of its uniform and leaves through the normal CDF,
+// kept below 1 so it stays within 18-79 years
+static void apply_copula(const CovariateCopula* copula, float u[][POPULATION_GEN_BLOCK],
+                         float z[][POPULATION_GEN_BLOCK], int n) {
+    float age[POPULATION_GEN_BLOCK] __attribute__((aligned(SOA_ALIGNMENT)));
+    for (int j = 0; j < n; j++) age[j] = (float)normal_quantile(u[U_AGE][j]);
+
+    float* const columns[COPULA_N_COVARIATES] = {
+        [COPULA_AGE] = age,
+        [COPULA_WEIGHT] = z[Z_WEIGHT],
+        [COPULA_BMI] = z[Z_BMI],
+        [COPULA_RENAL] = z[Z_RENAL],
+        [COPULA_HEPATIC] = z[Z_HEPATIC]
+    };
+    covariate_copula_apply(copula, columns, n);
+
+    for (int j = 0; j < n; j++) {
+        u[U_AGE][j] = sim_minf(0.5f * erfcf(-age[j] * (float)M_SQRT1_2), 0x1.fffffep-1f);
+    }
+}
+
+// Stratum h encodes ((pain_type * 4 + risk) * 4 + cyp2d6) * 4 + cyp3a4
+static void apply_stratification(const SamplingPlan* plan, const PopulationSoA* pop,
+                                 int first, int dest, int n) {
+    for (int j = 0; j < n; j++) {
+        int i = dest + j;
+        int slot = (int)rng_permute(&plan->strata, (uint32_t)(first + j));
+
+        // Last stratum whose first slot is <= slot
+        int lo = 0, hi = SAMPLING_STRATA - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (plan->stratum_start[mid] <= slot) lo = mid;
+            else hi = mid - 1;
+        }
+
+        int h = lo;
+        pop->cyp3a4_phenotype[i] = (uint8_t)(h % 4);
+        pop->cyp2d6_phenotype[i] = (uint8_t)(h / 4 % 4);
+        pop->risk_category[i] = (uint8_t)(h / 16 % 4);
+        pop->pain_type[i] = (uint8_t)(h / 64);
+        pop->sample_weight[i] = plan->stratum_weight[h];
+    }
+}
+
+// Patients [first, first + n) into column entries [dest, dest + n)
+static void generate_block(const PopulationSoA* pop, int first, int dest, int n,
+                           const AliasTable* pain_types, const AliasTable* risk_categories,
+                           const AliasTable* phenotypes, const SamplingPlan* plan,
+                           const CovariateCopula* copula) {
+    float u[N_UNIFORM_COLUMNS][POPULATION_GEN_BLOCK] __attribute__((aligned(SOA_ALIGNMENT)));
+    float z[N_NORMAL_COLUMNS][POPULATION_GEN_BLOCK] __attribute__((aligned(SOA_ALIGNMENT)));
+
+    RngBank bank = {
+        .seed = rng_get_seed(),
+        .stream = RNG_STREAM_POPULATION,
+        .first_patient = (uint32_t)first,
+        .n = n
+    };
+
+    for (int b = 0; b < N_UNIFORM_COLUMNS / 4; b++) {
+        rng_bank_uniform(&bank, UNIFORM_BLOCK_BASE + b, u[4 * b], u[4 * b + 1], u[4 * b + 2], u[4 * b + 3]);
+    }
+    for (int b = 0; b < N_NORMAL_COLUMNS / 2; b++) {
+        rng_bank_normal(&bank, NORMAL_BLOCK_BASE + b, z[2 * b], z[2 * b + 1]);
+    }
+
+    if (plan && (plan->mode & SAMPLING_LHS)) {
+        apply_latin_hypercube(plan, &bank, first, n, u, z);
+    }
+    if (copula) apply_copula(copula, u, z, n);
+
+    const PopulationSoA c = *pop;  // Column pointers in registers, not reloaded per store
+
+    // Hepatic function drops 0.1 over age 60. With a copula the age:hepatic
+    // correlation carries that dependence instead, around the same
+    // population mean (19 of the 62 age years are over 60)
+    const float hepatic_center = copula ? 1.0f - 0.1f * 19 / 62 : 1.0f;
+    const float hepatic_age_drop = copula ? 0 : 0.1f;
+
+    // Categorical columns
+    if (plan && (plan->mode & SAMPLING_STRATIFIED)) {
+        apply_stratification(plan, pop, first, dest, n);
+    } else {
+        alias_table_sample_batch(pain_types, u[U_PAIN_TYPE], c.pain_type + dest, n);
+        alias_table_sample_batch(risk_categories, u[U_RISK], c.risk_category + dest, n);
+        alias_table_sample_batch(phenotypes, u[U_CYP2D6], c.cyp2d6_phenotype + dest, n);
+        alias_table_sample_batch(phenotypes, u[U_CYP3A4], c.cyp3a4_phenotype + dest, n);
+        for (int j = 0; j < n; j++) c.sample_weight[dest + j] = 1.0f;
+    }
+
+    #pragma omp simd
+    for (int j = 0; j < n; j++) {
+        int i = dest + j;
+
+        // Demographics
+        c.patient_id[i] = first + j;
+        float age = 18 + (float)(int32_t)(u[U_AGE][j] * 62);  // 18-80 years
+        c.age[i] = age;
+        c.sex[i] = u[U_SEX][j] < 0.52f;  // 52% female
+        c.weight[i] = clamp(50 + 25 + z[Z_WEIGHT][j] * 15, 40, 150);  // kg
+        c.bmi[i] = clamp(18.5f + 6 + z[Z_BMI][j] * 4, 16, 45);
+
+        // Pain characteristics
+        uint8_t pain_type = c.pain_type[i];
+        c.baseline_pain_score[i] = clamp(4 + 2.5f + z[Z_BASELINE_PAIN][j] * 1.5f, 1, 10);
+        c.pain_duration_months[i] = 1 + (uint16_t)(u[U_PAIN_DURATION][j] * 120);  // 1-120 months
+
+        // Prior opioid use (30% have prior use)
+        uint8_t prior_use = u[U_PRIOR_USE][j] < 0.3f;
+        c.prior_opioid_use[i] = prior_use;
+        c.prior_opioid_dose_mme[i] = prior_use ? u[U_PRIOR_DOSE][j] * 90 : 0;
+
+        // Risk factors
+        c.addiction_history[i] = u[U_ADDICTION][j] < 0.1f;  // 10%
+        c.mental_health_comorbidity[i] = u[U_MENTAL_HEALTH][j] < 0.25f;  // 25%
+        c.respiratory_disease[i] = u[U_RESPIRATORY][j] < 0.12f;  // 12%
+
+        // Organ function
+        c.renal_function[i] = clamp(90 + z[Z_RENAL][j] * 20, 15, 120);  // eGFR
+        c.hepatic_function[i] = clamp(hepatic_center - (age > 60 ? hepatic_age_drop : 0) +
+                                         z[Z_HEPATIC][j] * 0.1f, 0.3f, 1.0f);
+
+        // Genetics
+        c.oprm1_variant[i] = u[U_OPRM1][j] < 0.15f;  // 15% prevalence
+        c.comt_variant[i] = u[U_COMT][j] < 0.25f;  // 25% prevalence
+
+        // Adherence (higher for cancer patients)
+        float za = z[Z_ADHERENCE][j];
+        c.adherence_probability[i] = pain_type == CHRONIC_CANCER
+            ? clamp(0.85f + za * 0.1f, 0.5f, 1.0f)
+            : clamp(0.7f + za * 0.15f, 0.3f, 0.95f);
+    }
+}
+
+// ============================================================================
+// SAMPLING PLANS
+// ============================================================================
+
+static const char* const SAMPLING_MODE_NAMES[] = {"random", "stratified", "lhs", "stratified-lhs"};
+
+int sampling_mode_from_name(const char* name, SamplingMode* mode) {
+    for (int m = 0; m <= SAMPLING_STRATIFIED_LHS; m++) {
+        if (strcmp(name, SAMPLING_MODE_NAMES[m]) == 0) {
+            *mode = (SamplingMode)m;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* sampling_mode_name(SamplingMode mode) {
+    return mode >= SAMPLING_RANDOM && mode <= SAMPLING_STRATIFIED_LHS ? SAMPLING_MODE_NAMES[mode]
+                                                                      : "unknown";
+}
+
+int sampling_plan_init(SamplingPlan* plan, SamplingMode mode, float allocation_power, int n) {
+    memset(plan, 0, sizeof(*plan));
+    plan->mode = mode;
+    plan->n = n;
+
+    uint64_t seed = rng_get_seed();
+    rng_permutation_init(&plan->strata, seed, 0, (uint32_t)n);
+    for (int d = 0; d < SAMPLING_LHS_COLUMNS; d++) {
+        rng_permutation_init(&plan->lhs[d], seed, 1 + d, (uint32_t)n);
+    }
+
+    if (!(mode & SAMPLING_STRATIFIED)) return 0;
+    if (!isfinite(allocation_power)) {
+        fprintf(stderr, "Error: stratum allocation power must be finite, got %g\n", allocation_power);
+        return -1;
+    }
+    if (n < SAMPLING_STRATA) {
+        fprintf(stderr, "Error: stratified sampling needs at least %d patients (one per stratum)\n",
+                SAMPLING_STRATA);
+        return -1;
+    }
+
+    // Population share of each stratum; the covariates are independent
+    double share[SAMPLING_STRATA], target[SAMPLING_STRATA], total = 0;
+    for (int h = 0; h < SAMPLING_STRATA; h++) {
+        share[h] = (double)pain_type_probs[h / 64] * risk_probs[h / 16 % 4] *
+                   genetic_probs[h / 4 % 4] * genetic_probs[h % 4];
+        target[h] = pow(share[h], allocation_power);
+        total += target[h];
+    }
+    if (!(isfinite(total) && total > 0)) {
+        fprintf(stderr, "Error: stratum allocation power %g gives no usable stratum sizes\n",
+                allocation_power);
+        return -1;
+    }
+
+    // One patient per stratum, the rest by largest remainder
+    int count[SAMPLING_STRATA], assigned = 0;
+    double spare = n - SAMPLING_STRATA;
+    for (int h = 0; h < SAMPLING_STRATA; h++) {
+        target[h] = spare * target[h] / total;
+        count[h] = 1 + (int)target[h];
+        target[h] -= (int)target[h];
+        assigned += count[h];
+    }
+    while (assigned < n) {
+        int best = 0;
+        for (int h = 1; h < SAMPLING_STRATA; h++) {
+            if (target[h] > target[best]) best = h;
+        }
+        count[best]++;
+        target[best] = -1;
+        assigned++;
+    }
+
+    plan->stratum_start[0] = 0;
+    for (int h = 0; h < SAMPLING_STRATA; h++) {
+        plan->stratum_start[h + 1] = plan->stratum_start[h] + count[h];
+        plan->stratum_weight[h] = (float)(share[h] * n / count[h]);
+    }
+    return 0;
+}
+
+// ============================================================================
+// POPULATION GENERATION
+// ============================================================================
+
+// Patients [first, last) into column entries from dest on
+static void generate_patients(PopulationSoA* pop, int first, int last, int dest,
+                              const SamplingPlan* plan) {
+    AliasTable pain_types, risk_categories, phenotypes;
+    alias_table_init(&pain_types, pain_type_probs, 5);
+    alias_table_init(&risk_categories, risk_probs, 4);
+    alias_table_init(&phenotypes, genetic_probs, 4);
+
+    int n_blocks = (last - first + POPULATION_GEN_BLOCK - 1) / POPULATION_GEN_BLOCK;
+    const CovariateCopula* copula = covariate_copula()->enabled ? covariate_copula() : NULL;
+
+    #pragma omp parallel for schedule(static)
+    for (int b = 0; b < n_blocks; b++) {
+        int block_first = first + b * POPULATION_GEN_BLOCK;
+        int block_n = last - block_first < POPULATION_GEN_BLOCK ? last - block_first : POPULATION_GEN_BLOCK;
+        generate_block(pop, block_first, dest + (block_first - first), block_n, &pain_types,
+                       &risk_categories, &phenotypes, plan, copula);
+    }
+}
+
+void generate_population_range(PopulationSoA* pop, int first, int last, const SamplingPlan* plan) {
+    generate_patients(pop, first, last, first, plan);
+}
+
+void generate_population_chunk(PopulationSoA* chunk, int first, int last, const SamplingPlan* plan) {
+    chunk->n = last - first;
+    generate_patients(chunk, first, last, 0, plan);
+}
+
+PopulationSoA* generate_population_soa(int n) {
+    return generate_population_soa_sampled(n, NULL);
+}
+
+PopulationSoA* generate_population_soa_sampled(int n, const SamplingPlan* plan) {
+    PopulationSoA* pop = population_soa_create(n);
+    if (!pop) return NULL;
+
+    generate_population_range(pop, 0, n, plan);
+    return pop;
+}
+
+PatientCharacteristics* generate_population(int n) {
+    PatientCharacteristics* patients = (PatientCharacteristics*)calloc(n, sizeof(PatientCharacteristics));
+    PopulationSoA* pop = generate_population_soa(n);
+    if (!patients || !pop) {
+        fprintf(stderr, "Failed to allocate memory for %d patients\n", n);
+        exit(1);
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++) {
+        population_soa_get(pop, i, &patients[i]);
+    }
+
+    population_soa_destroy(pop);
+    return patients;
+}
+
+void free_population(PatientCharacteristics* patients) {
+    free(patients);
+}
@@ -0,0 +1,93 @@
+/*
+ * population_gen.h - Columnar patient population generation
+ *
+ * Covariates are drawn column by column for blocks of patients with the
+ * bulk samplers in sim_rng.h, directly into a PopulationSoA. Patient i
+ * always receives the same covariates for a given run seed, independent
+ * of thread count or of which range of the population is generated.
+ *
+ * Population stream layout (Philox blocks of RNG_STREAM_POPULATION):
+ *   blocks 0-3  uniforms for the 14 categorical/flag/integer covariates
+ *   blocks 4-6  normals for weight, BMI, baseline pain, renal and hepatic
+ *               function, adherence
+ *   blocks 7-8  Latin-hypercube jitter for the normal covariates (LHS only)
+ *
+ * Sampling designs (SamplingPlan):
+ *   random      every covariate drawn independently (the default)
+ *   stratified  the joint categorical cell (pain type x risk category x
+ *               CYP2D6 x CYP3A4, 320 strata) is assigned, not drawn. Each
+ *               stratum receives a fixed number of patients, proportional
+ *               to (population share)^allocation_power with at least one
+ *               patient, and patients are spread over the population
+ *               index range by a keyed permutation. A power below 1
+ *               oversamples rare strata. Each patient carries the weight
+ *               population share / sample share of its stratum.
+ *   lhs         every other covariate is Latin-hypercube sampled: the
+ *               population range is cut into n equal-probability cells per
+ *               covariate and each cell is used exactly once.
+ * Estimators stay unbiased if they weight patients by sample_weight.
+ *
+ * Age, weight, BMI, renal and hepatic function can be correlated through
+ * a Gaussian copula (covariate_copula.h, a run setting), applied after
+ * the draws above without consuming any further random numbers.
+ */
+
+#ifndef POPULATION_GEN_H
+#define POPULATION_GEN_H
+
+#include "patient_sim.h"
+#include "population_soa.h"
+#include "sim_rng.h"
+
+// Patients per generation block; scratch columns live on the thread's stack
+#define POPULATION_GEN_BLOCK 512
+
+typedef enum {
+    SAMPLING_RANDOM = 0,
+    SAMPLING_STRATIFIED = 1 << 0,
+    SAMPLING_LHS = 1 << 1,
+    SAMPLING_STRATIFIED_LHS = SAMPLING_STRATIFIED | SAMPLING_LHS
+} SamplingMode;
+
+#define SAMPLING_STRATA (5 * 4 * 4 * 4)  // Pain type x risk x CYP2D6 x CYP3A4
+#define SAMPLING_LHS_COLUMNS 16          // Non-categorical covariates
+
+typedef struct {
+    SamplingMode mode;
+    int n;                                    // Population size the plan covers
+    int stratum_start[SAMPLING_STRATA + 1];   // Population slots of each stratum
+    float stratum_weight[SAMPLING_STRATA];
+    RngPermutation strata;
+    RngPermutation lhs[SAMPLING_LHS_COLUMNS];
+} SamplingPlan;
+
+// Returns 0, or -1 with a message if stratification needs more patients
+// than n (at least one per stratum) or allocation_power gives no finite
+// stratum sizes
+int sampling_plan_init(SamplingPlan* plan, SamplingMode mode, float allocation_power, int n);
+
+// "random", "stratified", "lhs" or "stratified-lhs"; -1 if unknown
+int sampling_mode_from_name(const char* name, SamplingMode* mode);
+const char* sampling_mode_name(SamplingMode mode);
+
+// Fills patients [first, last) of pop; plan NULL is simple random sampling,
+// otherwise plan->n must equal pop->n
+void generate_population_range(PopulationSoA* pop, int first, int last,
+                               const SamplingPlan* plan);
+
+// Fills entries [0, last - first) of chunk with patients [first, last) of
+// the population and sets chunk->n to their count; the patients keep their
+// population patient_id. chunk needs capacity for last - first patients,
+// plan->n (if plan is non-NULL) is the population size.
+void generate_population_chunk(PopulationSoA* chunk, int first, int last,
+                               const SamplingPlan* plan);
+
+// Returns NULL on allocation failure
+PopulationSoA* generate_population_soa(int n);
+PopulationSoA* generate_population_soa_sampled(int n, const SamplingPlan* plan);
+
+// AoS population for the scalar reference kernel
+PatientCharacteristics* generate_population(int n);
+void free_population(PatientCharacteristics* patients);
+
+#endif // POPULATION_GEN_H
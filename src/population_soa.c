@@ -0,0 +1,152 @@
+/*
+ * population_soa.c - Structure-of-arrays patient population store
+ */
+
+#include "population_soa.h"
+#include <string.h>
+#include <sys/mman.h>
+
+// ============================================================================
+// ALLOCATION
+// ============================================================================
+
+static size_t column_bytes(int capacity, size_t elem_size) {
+    size_t bytes = (size_t)capacity * elem_size;
+    return (bytes + SOA_ALIGNMENT - 1) & ~(size_t)(SOA_ALIGNMENT - 1);
+}
+
+int population_soa_capacity(int n) {
+    int capacity = (n + SOA_PAD_PATIENTS - 1) / SOA_PAD_PATIENTS * SOA_PAD_PATIENTS;
+    return capacity == 0 ? SOA_PAD_PATIENTS : capacity;
+}
+
+size_t population_soa_block_bytes(int capacity) {
+    size_t f32 = column_bytes(capacity, sizeof(float));
+    size_t u16 = column_bytes(capacity, sizeof(uint16_t));
+    size_t u8 = column_bytes(capacity, sizeof(uint8_t));
+    return f32 * 10 + u16 + u8 * 11;  // patient_id shares the 4-byte column size
+}
+
+void population_soa_bind(PopulationSoA* pop, void* block, int n, int capacity) {
+    size_t f32 = column_bytes(capacity, sizeof(float));
+    size_t u16 = column_bytes(capacity, sizeof(uint16_t));
+    size_t u8 = column_bytes(capacity, sizeof(uint8_t));
+
+    pop->n = n;
+    pop->capacity = capacity;
+    pop->block = block;
+
+    char* cursor = (char*)block;
+#define TAKE_COLUMN(field, type, bytes) \
+    pop->field = (type*)cursor;         \
+    cursor += (bytes)
+
+    TAKE_COLUMN(patient_id, int32_t, f32);
+    TAKE_COLUMN(age, float, f32);
+    TAKE_COLUMN(weight, float, f32);
+    TAKE_COLUMN(bmi, float, f32);
+    TAKE_COLUMN(baseline_pain_score, float, f32);
+    TAKE_COLUMN(prior_opioid_dose_mme, float, f32);
+    TAKE_COLUMN(renal_function, float, f32);
+    TAKE_COLUMN(hepatic_function, float, f32);
+    TAKE_COLUMN(adherence_probability, float, f32);
+    TAKE_COLUMN(sample_weight, float, f32);
+    TAKE_COLUMN(pain_duration_months, uint16_t, u16);
+    TAKE_COLUMN(sex, uint8_t, u8);
+    TAKE_COLUMN(pain_type, uint8_t, u8);
+    TAKE_COLUMN(risk_category, uint8_t, u8);
+    TAKE_COLUMN(cyp2d6_phenotype, uint8_t, u8);
+    TAKE_COLUMN(cyp3a4_phenotype, uint8_t, u8);
+    TAKE_COLUMN(prior_opioid_use, uint8_t, u8);
+    TAKE_COLUMN(addiction_history, uint8_t, u8);
+    TAKE_COLUMN(mental_health_comorbidity, uint8_t, u8);
+    TAKE_COLUMN(respiratory_disease, uint8_t, u8);
+    TAKE_COLUMN(oprm1_variant, uint8_t, u8);
+    TAKE_COLUMN(comt_variant, uint8_t, u8);
+#undef TAKE_COLUMN
+}
+
+PopulationSoA* population_soa_create(int n) {
+    PopulationSoA* pop = (PopulationSoA*)calloc(1, sizeof(PopulationSoA));
+    if (!pop) return NULL;
+
+    int capacity = population_soa_capacity(n);
+    size_t total = population_soa_block_bytes(capacity);
+    char* block = (char*)aligned_alloc(SOA_ALIGNMENT, total);
+    if (!block) {
+        free(pop);
+        return NULL;
+    }
+    memset(block, 0, total);
+
+    population_soa_bind(pop, block, n, capacity);
+    return pop;
+}
+
+void population_soa_destroy(PopulationSoA* pop) {
+    if (!pop) return;
+    if (pop->mapping) {
+        munmap(pop->mapping, pop->mapping_bytes);
+    } else {
+        free(pop->block);
+    }
+    free(pop);
+}
+
+// ============================================================================
+// AOS <-> SOA CONVERSION
+// ============================================================================
+
+void population_soa_from_aos(PopulationSoA* pop, const PatientCharacteristics* patients) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < pop->n; i++) {
+        const PatientCharacteristics* p = &patients[i];
+        pop->patient_id[i] = p->patient_id;
+        pop->age[i] = p->age;
+        pop->weight[i] = p->weight;
+        pop->bmi[i] = p->bmi;
+        pop->baseline_pain_score[i] = p->baseline_pain_score;
+        pop->prior_opioid_dose_mme[i] = p->prior_opioid_dose_mme;
+        pop->renal_function[i] = p->renal_function;
+        pop->hepatic_function[i] = p->hepatic_function;
+        pop->adherence_probability[i] = p->adherence_probability;
+        pop->sample_weight[i] = 1.0f;
+        pop->pain_duration_months[i] = p->pain_duration_months;
+        pop->sex[i] = p->sex;
+        pop->pain_type[i] = p->pain_type;
+        pop->risk_category[i] = p->risk_category;
+        pop->cyp2d6_phenotype[i] = p->cyp2d6_phenotype;
+        pop->cyp3a4_phenotype[i] = p->cyp3a4_phenotype;
+        pop->prior_opioid_use[i] = p->prior_opioid_use;
+        pop->addiction_history[i] = p->addiction_history;
+        pop->mental_health_comorbidity[i] = p->mental_health_comorbidity;
+        pop->respiratory_disease[i] = p->respiratory_disease;
+        pop->oprm1_variant[i] = p->oprm1_variant;
+        pop->comt_variant[i] = p->comt_variant;
+    }
+}
+
+void population_soa_get(const PopulationSoA* pop, int i, PatientCharacteristics* out) {
+    memset(out, 0, sizeof(*out));
+    out->patient_id = pop->patient_id[i];
+    out->age = (uint8_t)pop->age[i];
+    out->weight = pop->weight[i];
+    out->bmi = pop->bmi[i];
+    out->baseline_pain_score = pop->baseline_pain_score[i];
+    out->prior_opioid_dose_mme = pop->prior_opioid_dose_mme[i];
+    out->renal_function = pop->renal_function[i];
+    out->hepatic_function = pop->hepatic_function[i];
+    out->adherence_probability = pop->adherence_probability[i];
+    out->pain_duration_months = pop->pain_duration_months[i];
+    out->sex = pop->sex[i];
+    out->pain_type = pop->pain_type[i];
+    out->risk_category = pop->risk_category[i];
+    out->cyp2d6_phenotype = pop->cyp2d6_phenotype[i];
+    out->cyp3a4_phenotype = pop->cyp3a4_phenotype[i];
+    out->prior_opioid_use = pop->prior_opioid_use[i];
+    out->addiction_history = pop->addiction_history[i];
+    out->mental_health_comorbidity = pop->mental_health_comorbidity[i];
+    out->respiratory_disease = pop->respiratory_disease[i];
+    out->oprm1_variant = pop->oprm1_variant[i];
+    out->comt_variant = pop->comt_variant[i];
+}
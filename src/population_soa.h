@@ -0,0 +1,78 @@
+/*
+ * population_soa.h - Structure-of-arrays patient population store
+ *
+ * Every covariate lives in its own 64-byte aligned column, so lane setup
+ * in the batch kernel and bulk covariate generation touch only the fields
+ * they need instead of striding through PatientCharacteristics records.
+ * Columns are padded to a multiple of SOA_PAD_PATIENTS entries.
+ *
+ * The columns can also live in a read-only file mapping (population_cache.h),
+ * which stores the column block byte for byte.
+ */
+
+#ifndef POPULATION_SOA_H
+#define POPULATION_SOA_H
+
+#include "patient_sim.h"
+#include <stdint.h>
+
+#define SOA_ALIGNMENT 64
+#define SOA_PAD_PATIENTS 16
+
+typedef struct {
+    int n;
+    int capacity;          // Padded column length
+    void* block;           // Single allocation backing all columns
+    void* mapping;         // File mapping holding block, or NULL if allocated
+    size_t mapping_bytes;
+
+    int32_t* patient_id;
+
+    // Continuous covariates (float for direct use in lane loops)
+    float* age;
+    float* weight;
+    float* bmi;
+    float* baseline_pain_score;
+    float* prior_opioid_dose_mme;
+    float* renal_function;
+    float* hepatic_function;
+    float* adherence_probability;
+
+    // Estimator weight of each patient: 1 under simple random sampling,
+    // population share / sample share of its stratum otherwise
+    float* sample_weight;
+
+    uint16_t* pain_duration_months;
+
+    // Categorical covariates and flags
+    uint8_t* sex;
+    uint8_t* pain_type;
+    uint8_t* risk_category;
+    uint8_t* cyp2d6_phenotype;
+    uint8_t* cyp3a4_phenotype;
+    uint8_t* prior_opioid_use;
+    uint8_t* addiction_history;
+    uint8_t* mental_health_comorbidity;
+    uint8_t* respiratory_disease;
+    uint8_t* oprm1_variant;
+    uint8_t* comt_variant;
+} PopulationSoA;
+
+// Returns NULL on allocation failure
+PopulationSoA* population_soa_create(int n);
+void population_soa_destroy(PopulationSoA* pop);
+
+// Column block layout: capacity is n padded to SOA_PAD_PATIENTS, and
+// population_soa_bind() points the columns of pop into a block of
+// population_soa_block_bytes(capacity) bytes, aligned to SOA_ALIGNMENT
+int population_soa_capacity(int n);
+size_t population_soa_block_bytes(int capacity);
+void population_soa_bind(PopulationSoA* pop, void* block, int n, int capacity);
+
+// Transposes an AoS population into the column store
+void population_soa_from_aos(PopulationSoA* pop, const PatientCharacteristics* patients);
+
+// Reassembles one patient record (for the scalar kernel and CSV export)
+void population_soa_get(const PopulationSoA* pop, int i, PatientCharacteristics* out);
+
+#endif // POPULATION_SOA_H
@@ -0,0 +1,122 @@
+/*
+ * progress.c - Lock-free simulation progress tracking
+ */
+
+#include "progress.h"
+#include <pthread.h>
+#include <errno.h>
+
+// ============================================================================
+// GLOBAL STATE
+// ============================================================================
+
+ProgressSlot progress_slots[PROGRESS_MAX_SLOTS];
+
+static atomic_long progress_target;
+static int progress_threads;  // Team size of the parallel region being tracked
+
+// Reporter thread; the condition variable lets progress_stop() wake it
+// immediately instead of waiting out the report interval
+static pthread_t reporter;
+static pthread_mutex_t reporter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reporter_wake = PTHREAD_COND_INITIALIZER;
+static int reporter_running = 0;
+
+// ============================================================================
+// COUNTERS
+// ============================================================================
+
+long progress_completed(void) {
+    long completed = 0;
+    for (int i = 0; i < PROGRESS_MAX_SLOTS; i++) {
+        completed += atomic_load_explicit(&progress_slots[i].completed, memory_order_relaxed);
+    }
+    return completed;
+}
+
+long progress_total(void) {
+    return atomic_load_explicit(&progress_target, memory_order_relaxed);
+}
+
+void progress_busy(ProgressBusy* out) {
+    int threads = progress_threads < PROGRESS_MAX_SLOTS ? progress_threads : PROGRESS_MAX_SLOTS;
+    out->threads = threads;
+    out->min = threads > 0 ? 1e300 : 0;
+    out->mean = 0;
+    out->max = 0;
+    for (int i = 0; i < threads; i++) {
+        double busy = atomic_load_explicit(&progress_slots[i].busy_ns, memory_order_relaxed) * 1e-9;
+        if (busy < out->min) out->min = busy;
+        if (busy > out->max) out->max = busy;
+        out->mean += busy / threads;
+    }
+}
+
+static void print_progress(long completed, long total) {
+    printf("\rProgress: %ld/%ld patients (%.1f%%)",
+           completed, total, total > 0 ? 100.0 * completed / total : 100.0);
+    fflush(stdout);
+}
+
+// ============================================================================
+// REPORTER THREAD
+// ============================================================================
+
+static void* reporter_main(void* arg) {
+    (void)arg;
+    long interval_ns = (long)(PROGRESS_REPORT_INTERVAL * 1e9);
+
+    pthread_mutex_lock(&reporter_mutex);
+    while (reporter_running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += interval_ns;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+
+        int rc = pthread_cond_timedwait(&reporter_wake, &reporter_mutex, &deadline);
+        if (rc == ETIMEDOUT && reporter_running) {
+            print_progress(progress_completed(), progress_total());
+        }
+    }
+    pthread_mutex_unlock(&reporter_mutex);
+    return NULL;
+}
+
+void progress_start(long total, int report) {
+    for (int i = 0; i < PROGRESS_MAX_SLOTS; i++) {
+        atomic_store_explicit(&progress_slots[i].completed, 0, memory_order_relaxed);
+        atomic_store_explicit(&progress_slots[i].busy_ns, 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&progress_target, total, memory_order_relaxed);
+    progress_threads = omp_get_max_threads();
+
+    if (!report) return;
+
+    reporter_running = 1;
+    if (pthread_create(&reporter, NULL, reporter_main, NULL) != 0) {
+        reporter_running = 0;  // Progress stays pollable, just not printed
+    }
+}
+
+void progress_stop(void) {
+    pthread_mutex_lock(&reporter_mutex);
+    int was_running = reporter_running;
+    reporter_running = 0;
+    pthread_cond_signal(&reporter_wake);
+    pthread_mutex_unlock(&reporter_mutex);
+
+    if (was_running) {
+        pthread_join(reporter, NULL);
+        print_progress(progress_completed(), progress_total());
+        printf("\n");
+
+        ProgressBusy busy;
+        progress_busy(&busy);
+        if (busy.mean > 0) {
+            printf("  Thread busy time: min %.3f / mean %.3f / max %.3f s over %d threads "
+                   "(imbalance %.1f%%)\n", busy.min, busy.mean, busy.max, busy.threads,
+                   100.0 * (busy.max / busy.mean - 1));
+        }
+    }
+}
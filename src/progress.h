@@ -0,0 +1,60 @@
+/*
+ * progress.h - Lock-free simulation progress tracking
+ *
+ * Workers add completed patients to their own cache-line padded counter
+ * with a relaxed atomic, so progress never serializes the parallel loop.
+ * A reporter thread sums the counters a few times per second and prints
+ * the progress line; the totals can also be polled directly.
+ *
+ * Workers also add the time spent inside their work items, so load
+ * imbalance between threads shows up as a spread in busy time; the
+ * reporter prints it when the run stops.
+ */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include "patient_sim.h"
+#include <stdatomic.h>
+
+#define PROGRESS_MAX_SLOTS 256         // Threads beyond this share slots
+#define PROGRESS_REPORT_INTERVAL 0.5   // Seconds between progress lines
+
+typedef struct {
+    _Alignas(64) atomic_long completed;
+    atomic_long busy_ns;     // Time inside work items
+} ProgressSlot;
+
+typedef struct {
+    int threads;             // Threads of the parallel region
+    double min, mean, max;   // Busy seconds per thread
+} ProgressBusy;
+
+extern ProgressSlot progress_slots[PROGRESS_MAX_SLOTS];
+
+// Resets the counters and, if report is nonzero, starts the reporter thread
+void progress_start(long total, int report);
+
+// Stops the reporter and prints the final progress line
+void progress_stop(void);
+
+// Records n more completed patients for the calling OpenMP thread
+static inline void progress_add(long n) {
+    ProgressSlot* slot = &progress_slots[omp_get_thread_num() % PROGRESS_MAX_SLOTS];
+    atomic_fetch_add_explicit(&slot->completed, n, memory_order_relaxed);
+}
+
+// Records time the calling OpenMP thread spent on work items
+static inline void progress_add_busy(double seconds) {
+    ProgressSlot* slot = &progress_slots[omp_get_thread_num() % PROGRESS_MAX_SLOTS];
+    atomic_fetch_add_explicit(&slot->busy_ns, (long)(seconds * 1e9), memory_order_relaxed);
+}
+
+long progress_completed(void);
+long progress_total(void);
+
+// Busy time per thread since progress_start(); threads that got no work
+// count as zero
+void progress_busy(ProgressBusy* out);
+
+#endif // PROGRESS_H
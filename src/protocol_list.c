@@ -0,0 +1,346 @@
+/*
+ * protocol_list.c - Named protocol lists for sweep mode
+ */
+
+#include "protocol_list.h"
+#include "config_yaml.h"
+
+void protocol_list_init(ProtocolList* list) {
+    memset(list, 0, sizeof(*list));
+}
+
+void protocol_list_free(ProtocolList* list) {
+    free(list->protocols);
+    free(list->names);
+    free(list->schedules);
+    protocol_list_init(list);
+}
+
+int protocol_list_add(ProtocolList* list, const char* name, const Protocol* protocol) {
+    DoseSchedule schedule;
+    dose_schedule_from_protocol(&schedule, protocol);
+    if (protocol_list_add_schedule(list, name, &schedule) != 0) return -1;
+    list->protocols[list->n - 1] = *protocol;
+    return 0;
+}
+
+int protocol_list_add_schedule(ProtocolList* list, const char* name, const DoseSchedule* schedule) {
+    if (list->n == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        Protocol* protocols = (Protocol*)realloc(list->protocols, capacity * sizeof(Protocol));
+        if (!protocols) return -1;
+        list->protocols = protocols;
+
+        char (*names)[PROTOCOL_NAME_LEN] = realloc(list->names, capacity * sizeof(*names));
+        if (!names) return -1;
+        list->names = names;
+
+        DoseSchedule* schedules = (DoseSchedule*)realloc(list->schedules, capacity * sizeof(DoseSchedule));
+        if (!schedules) return -1;
+        list->schedules = schedules;
+        list->capacity = capacity;
+    }
+
+    list->protocols[list->n] = dose_schedule_nominal(schedule);
+    list->schedules[list->n] = *schedule;
+    snprintf(list->names[list->n], PROTOCOL_NAME_LEN, "%s", name);
+    list->n++;
+    return 0;
+}
+
+int protocol_list_load_table(ProtocolList* list, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open sweep table %s\n", path);
+        return -1;
+    }
+
+    char line[512];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char name[PROTOCOL_NAME_LEN];
+        Protocol protocol;
+        char extra;
+        int fields = sscanf(line, "%63s %f %f %f %c", name, &protocol.sr17018_dose,
+                            &protocol.sr14968_dose, &protocol.dpp26_dose, &extra);
+        if (fields <= 0) continue;  // Blank or comment-only line
+
+        if (fields != 4 || protocol.sr17018_dose < 0 || protocol.sr14968_dose < 0 ||
+            protocol.dpp26_dose < 0) {
+            fprintf(stderr, "Error: %s:%d: expected \"name sr17018 sr14968 dpp26\" with doses >= 0\n",
+                    path, line_no);
+            fclose(f);
+            return -1;
+        }
+        if (protocol_list_add(list, name, &protocol) != 0) {
+            fprintf(stderr, "Error: out of memory reading %s\n", path);
+            fclose(f);
+            return -1;
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
+
+int protocol_list_find(const ProtocolList* list, const char* name) {
+    for (int p = 0; p < list->n; p++) {
+        if (strcmp(list->names[p], name) == 0) return p;
+    }
+    return -1;
+}
+
+// ============================================================================
+// PROTOCOL CONFIGURATION FILES
+// ============================================================================
+
+static int compound_from_name(const char* name, PkCompound* compound) {
+    if (strcmp(name, "sr17018") == 0) {
+        *compound = PK_SR17018;
+    } else if (strcmp(name, "sr14968") == 0) {
+        *compound = PK_SR14968;
+    } else if (strcmp(name, "dpp26") == 0 || strcmp(name, "oxycodone") == 0) {
+        *compound = PK_DPP26;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Optional `formulation` and `release_hours` of a compound mapping; the
+// formulation holds for every phase, so phases must not disagree on it
+static int load_compound_formulation(const YamlDocument* doc, const YamlEntry* compound_entry,
+                                     PkCompound compound, DoseSchedule* s, const char* path) {
+    const char* key = compound_entry->key;
+    const char* name = yaml_child_value(doc, key, "formulation");
+    const char* hours_text = yaml_child_value(doc, key, "release_hours");
+    if (!name && !hours_text) return 0;
+
+    PkFormulation formulation = s->formulation[compound];
+    if (name && pk_formulation_from_name(name, &formulation) != 0) {
+        fprintf(stderr, "Error: %s:%d: %s: unknown formulation %s (immediate_release, "
+                        "sustained_release or extended_release)\n",
+                path, compound_entry->line, key, name);
+        return -1;
+    }
+    if (s->formulation[compound] != PK_IMMEDIATE_RELEASE && formulation != s->formulation[compound]) {
+        fprintf(stderr, "Error: %s:%d: %s: formulation differs from an earlier phase\n",
+                path, compound_entry->line, key);
+        return -1;
+    }
+
+    char* end = NULL;
+    float hours = hours_text ? strtof(hours_text, &end) : s->release_hours[compound];
+    if ((hours_text && (end == hours_text || *end != '\0')) ||
+        dose_schedule_set_formulation(s, compound, formulation, hours) != 0) {
+        fprintf(stderr, "Error: %s:%d: %s.release_hours must be in [0, 24]\n",
+                path, compound_entry->line, key);
+        return -1;
+    }
+    return 0;
+}
+
+// Adds the administrations described by the compound mapping at `key`
+static int load_compound_doses(const YamlDocument* doc, const YamlEntry* compound_entry,
+                               PkCompound compound, DoseSchedule* s, const char* path) {
+    const char* key = compound_entry->key;
+    const char* dose_text = yaml_child_value(doc, key, "dose_mg");
+    char* end = NULL;
+    float dose = dose_text ? strtof(dose_text, &end) : -1.0f;
+    if (!dose_text || end == dose_text || *end != '\0' || dose < 0) {
+        fprintf(stderr, "Error: %s:%d: %s needs a dose_mg >= 0\n", path, compound_entry->line, key);
+        return -1;
+    }
+
+    float hours[DOSE_MAX_PER_DAY];
+    int n_hours;
+    const char* times = yaml_child_value(doc, key, "administration_times");
+    const char* frequency = yaml_child_value(doc, key, "frequency");
+    if (times) {
+        n_hours = yaml_parse_floats(times, hours, DOSE_MAX_PER_DAY);
+        if (n_hours < 0) {
+            fprintf(stderr, "Error: %s:%d: %s.administration_times must list up to %d hours\n",
+                    path, compound_entry->line, key, DOSE_MAX_PER_DAY);
+            return -1;
+        }
+    } else if (frequency && (n_hours = dose_frequency_per_day(frequency)) > 0) {
+        for (int d = 0; d < n_hours; d++) hours[d] = 24.0f * d / n_hours;
+    } else {
+        fprintf(stderr, "Error: %s:%d: %s needs administration_times or a frequency "
+                        "(QD, BID, TID, QID or Q<n>H)\n", path, compound_entry->line, key);
+        return -1;
+    }
+
+    for (int d = 0; d < n_hours; d++) {
+        if (dose_schedule_add(s, compound, hours[d], dose) != 0) {
+            fprintf(stderr, "Error: %s:%d: %s: administration hour %g is outside [0, 24) "
+                            "or there are more than %d doses a day\n",
+                    path, compound_entry->line, key, hours[d], DOSE_MAX_PER_DAY);
+            return -1;
+        }
+    }
+    return load_compound_formulation(doc, compound_entry, compound, s, path);
+}
+
+// Adds every compound mapping directly below `parent` to the last phase of s
+static int load_phase_compounds(const YamlDocument* doc, const YamlEntry* parent,
+                                DoseSchedule* s, const char* path) {
+    size_t prefix = strlen(parent->key);
+    for (int j = (int)(parent - doc->entries) + 1; j < doc->n; j++) {
+        const YamlEntry* e = &doc->entries[j];
+        if (e->depth != parent->depth + 1 || strncmp(e->key, parent->key, prefix) != 0 ||
+            e->key[prefix] != '.') {
+            continue;
+        }
+
+        PkCompound compound;
+        if (compound_from_name(e->key + prefix + 1, &compound) != 0) {
+            fprintf(stderr, "Error: %s:%d: unknown compound %s (sr17018, sr14968, dpp26 "
+                            "or oxycodone)\n", path, e->line, e->key + prefix + 1);
+            return -1;
+        }
+        if (load_compound_doses(doc, e, compound, s, path) != 0) return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    const YamlEntry* entry;
+    int start_day;
+} PhaseEntry;
+
+static int compare_phase_start(const void* a, const void* b) {
+    return ((const PhaseEntry*)a)->start_day - ((const PhaseEntry*)b)->start_day;
+}
+
+// Titration phases of the protocol at `top`: week_<n> starts on day
+// 7 * (n - 1), day_<n> on day n - 1, and maintenance after the last of them.
+// Returns the number of phases found, or -1 with a message.
+static int find_phases(const YamlDocument* doc, const YamlEntry* top, PhaseEntry* phases,
+                       const char* path) {
+    size_t prefix = strlen(top->key);
+    int n = 0, end_day = 0, overflow = 0;
+    const YamlEntry* maintenance = NULL;
+    for (int j = (int)(top - doc->entries) + 1; j < doc->n; j++) {
+        const YamlEntry* e = &doc->entries[j];
+        if (e->depth != 1 || strncmp(e->key, top->key, prefix) != 0 || e->key[prefix] != '.') {
+            continue;
+        }
+
+        const char* name = e->key + prefix + 1;
+        int number, start, length;
+        char extra;
+        if (sscanf(name, "week_%d%c", &number, &extra) == 1 && number >= 1) {
+            start = 7 * (number - 1);
+            length = 7;
+        } else if (sscanf(name, "day_%d%c", &number, &extra) == 1 && number >= 1) {
+            start = number - 1;
+            length = 1;
+        } else {
+            if (strcmp(name, "maintenance") == 0) maintenance = e;
+            continue;
+        }
+
+        if (n == DOSE_MAX_PHASES) {
+            overflow = 1;
+            break;
+        }
+        phases[n++] = (PhaseEntry){e, start};
+        if (start + length > end_day) end_day = start + length;
+    }
+
+    // A schedule whose first phase starts after day 0 keeps an empty phase 0
+    // in front of it, which takes a slot too
+    int first_day = end_day;
+    for (int p = 0; p < n; p++) {
+        if (phases[p].start_day < first_day) first_day = phases[p].start_day;
+    }
+    int slots = n + (maintenance != NULL) + (first_day > 0);
+    if (overflow || slots > DOSE_MAX_PHASES) {
+        fprintf(stderr, "Error: %s:%d: %s has more than %d phases%s\n", path, top->line, top->key,
+                DOSE_MAX_PHASES, first_day > 0 ? ", counting the empty phase before the first" : "");
+        return -1;
+    }
+
+    if (maintenance) phases[n++] = (PhaseEntry){maintenance, end_day};
+    qsort(phases, n, sizeof(PhaseEntry), compare_phase_start);
+    return n;
+}
+
+int protocol_list_load_config(ProtocolList* list, const char* path) {
+    YamlDocument doc;
+    if (yaml_load(&doc, path) != 0) return -1;
+
+    int status = 0;
+    for (int i = 0; i < doc.n && status == 0; i++) {
+        const YamlEntry* top = &doc.entries[i];
+        if (top->depth != 0) continue;
+
+        // Fixed regimen under compounds:, or titration phases
+        char key[YAML_KEY_LEN + 16];
+        snprintf(key, sizeof(key), "%s.compounds", top->key);
+        const YamlEntry* compounds = yaml_find(&doc, key);
+        PhaseEntry phases[DOSE_MAX_PHASES];
+        int n_phases = find_phases(&doc, top, phases, path);
+        if (n_phases < 0) {
+            status = -1;
+            break;
+        }
+        if (!compounds && n_phases == 0) continue;  // Not a protocol
+        if (compounds && n_phases > 0) {
+            fprintf(stderr, "Error: %s:%d: %s has both compounds: and titration phases\n",
+                    path, top->line, top->key);
+            status = -1;
+            break;
+        }
+
+        DoseSchedule schedule;
+        dose_schedule_init(&schedule);
+        if (compounds) {
+            status = load_phase_compounds(&doc, compounds, &schedule, path);
+        }
+        for (int p = 0; p < n_phases && status == 0; p++) {
+            if (dose_schedule_begin_phase(&schedule, phases[p].start_day) != 0) {
+                fprintf(stderr, "Error: %s:%d: phase %s starts on the same day as another\n",
+                        path, phases[p].entry->line, phases[p].entry->key);
+                status = -1;
+            } else {
+                status = load_phase_compounds(&doc, phases[p].entry, &schedule, path);
+            }
+        }
+
+        if (status == 0 && protocol_list_add_schedule(list, top->key, &schedule) != 0) {
+            fprintf(stderr, "Error: out of memory reading %s\n", path);
+            status = -1;
+        }
+    }
+
+    yaml_free(&doc);
+    return status;
+}
+
+int protocol_list_load(ProtocolList* list, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open protocol file %s\n", path);
+        return -1;
+    }
+
+    // Table rows never contain ':'; the first entry of a configuration does
+    int config = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        if (strspn(line, " \t\r\n") == strlen(line)) continue;
+        config = strchr(line, ':') != NULL;
+        break;
+    }
+    fclose(f);
+
+    return config ? protocol_list_load_config(list, path) : protocol_list_load_table(list, path);
+}
@@ -0,0 +1,66 @@
+/*
+ * protocol_list.h - Named protocol lists for sweep mode
+ *
+ * Sweep tables are plain text, one protocol per line:
+ *
+ *   # name          sr17018  sr14968  dpp26   (mg per dose)
+ *   baseline        16.17    25.31    5.07
+ *   high_dose       32.0     15.0     7.5
+ *
+ * Blank lines and '#' comments are ignored. Table rows use the standard
+ * regimen (SR-17018 BID, SR-14968 QD, DPP-26 Q6H).
+ *
+ * Protocol configuration files (protocol_config.c) are read too: every
+ * top-level key with a `compounds:` mapping is a protocol, and each
+ * compound gives `dose_mg` plus `administration_times` (hours) or a
+ * `frequency` such as "BID" or "Q8H". Oxycodone entries dose the DPP-26
+ * slot, which replaces oxycodone in the simulated regimen. An optional
+ * `formulation` ("immediate_release", "sustained_release" or
+ * "extended_release", zero-order) and `release_hours` select the
+ * absorption kinetics; see pk_engine.h.
+ *
+ * Titration protocols list phases instead of `compounds:`, each holding
+ * compound mappings: `week_<n>` covers days 7(n-1) .. 7n-1, `day_<n>` day
+ * n-1, and `maintenance` starts after the last of them. A compound missing
+ * from a phase is not given during that phase.
+ */
+
+#ifndef PROTOCOL_LIST_H
+#define PROTOCOL_LIST_H
+
+#include "patient_sim.h"
+#include "dose_schedule.h"
+
+#define PROTOCOL_NAME_LEN 64
+
+typedef struct {
+    int n;
+    int capacity;
+    Protocol* protocols;                // Nominal dose per administration
+    DoseSchedule* schedules;            // What the kernels run
+    char (*names)[PROTOCOL_NAME_LEN];
+} ProtocolList;
+
+void protocol_list_init(ProtocolList* list);
+void protocol_list_free(ProtocolList* list);
+
+// Standard regimen at the protocol's doses; returns 0, or -1 on
+// allocation failure
+int protocol_list_add(ProtocolList* list, const char* name, const Protocol* protocol);
+int protocol_list_add_schedule(ProtocolList* list, const char* name, const DoseSchedule* schedule);
+
+// Appends every protocol of a sweep table; returns 0, or -1 with a message
+// naming the file and line
+int protocol_list_load_table(ProtocolList* list, const char* path);
+
+// Appends every protocol of a protocol_config.c-style file, in file order
+int protocol_list_load_config(ProtocolList* list, const char* path);
+
+// Either format: a file whose first entry is a "key:" line is a
+// configuration file, anything else a sweep table
+int protocol_list_load(ProtocolList* list, const char* path);
+
+// Index of the protocol called name, or -1
+int protocol_list_find(const ProtocolList* list, const char* name);
+
+#endif // PROTOCOL_LIST_H
@@ -0,0 +1,326 @@
+/*
+ * sim_config.c - Run configuration and command line
+ */
+
+#include "sim_config.h"
+#include <getopt.h>
+#include <limits.h>
+
+#define MAX_TIMESTEPS_PER_DAY (24 * 60)
+
+// ============================================================================
+// TREATMENT GRID
+// ============================================================================
+
+static int run_days = SIMULATION_DAYS;
+static int run_timesteps_per_day = TIMESTEPS_PER_DAY;
+
+int sim_set_grid(int days, int timesteps_per_day) {
+    if (days < 1 || days > SIMULATION_DAYS) {
+        fprintf(stderr, "Error: %d days is outside 1..%d (SIMULATION_DAYS)\n", days, SIMULATION_DAYS);
+        return -1;
+    }
+    if (timesteps_per_day < 1 || timesteps_per_day > MAX_TIMESTEPS_PER_DAY) {
+        fprintf(stderr, "Error: %d timesteps per day is outside 1..%d\n", timesteps_per_day,
+                MAX_TIMESTEPS_PER_DAY);
+        return -1;
+    }
+    run_days = days;
+    run_timesteps_per_day = timesteps_per_day;
+    return 0;
+}
+
+int sim_days(void) {
+    return run_days;
+}
+
+int sim_timesteps_per_day(void) {
+    return run_timesteps_per_day;
+}
+
+// ============================================================================
+// COMMAND LINE
+// ============================================================================
+
+enum {
+    OPT_SEED = 256,
+    OPT_PROTOCOL_FILE,
+    OPT_PROTOCOL,
+    OPT_DOSES,
+    OPT_SWEEP,
+    OPT_PAIRED,
+    OPT_SAMPLING,
+    OPT_ALLOCATION_POWER,
+    OPT_ADAPTIVE,
+    OPT_PK_MODEL,
+    OPT_TOLERANCE,
+    OPT_WITHDRAWAL,
+    OPT_POPULATION_CACHE,
+    OPT_CHUNK,
+    OPT_COVARIATE_CORRELATION
+};
+
+static const struct option long_options[] = {
+    {"patients", required_argument, NULL, 'n'},
+    {"days", required_argument, NULL, 'd'},
+    {"timesteps", required_argument, NULL, 's'},
+    {"threads", required_argument, NULL, 't'},
+    {"config", required_argument, NULL, 'c'},
+    {"seed", required_argument, NULL, OPT_SEED},
+    {"protocol-file", required_argument, NULL, OPT_PROTOCOL_FILE},
+    {"protocol", required_argument, NULL, OPT_PROTOCOL},
+    {"doses", required_argument, NULL, OPT_DOSES},
+    {"sweep", required_argument, NULL, OPT_SWEEP},
+    {"paired", no_argument, NULL, OPT_PAIRED},
+    {"sampling", required_argument, NULL, OPT_SAMPLING},
+    {"allocation-power", required_argument, NULL, OPT_ALLOCATION_POWER},
+    {"adaptive", required_argument, NULL, OPT_ADAPTIVE},
+    {"pk-model", required_argument, NULL, OPT_PK_MODEL},
+    {"tolerance", required_argument, NULL, OPT_TOLERANCE},
+    {"withdrawal", required_argument, NULL, OPT_WITHDRAWAL},
+    {"population-cache", required_argument, NULL, OPT_POPULATION_CACHE},
+    {"chunk", required_argument, NULL, OPT_CHUNK},
+    {"covariate-correlation", required_argument, NULL, OPT_COVARIATE_CORRELATION},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+};
+
+void sim_config_usage(FILE* f, const char* program) {
+    fprintf(f,
+            "Usage: %s [options] [protocol_config.c]\n"
+            "\n"
+            "Run size:\n"
+            "  -n, --patients N          Patients to simulate (default %d)\n"
+            "  -d, --days N              Treatment days, 1..%d (default %d)\n"
+            "  -s, --timesteps N         Timesteps per day (default %d)\n"
+            "  -t, --threads N           Thread cap (default %d)\n"
+            "  -c, --config PATH         Read random_seed from a protocol_config.c file\n"
+            "      --seed N              Random seed (overrides --config)\n"
+            "      --pk-model MODEL      one-compartment (default) or two-compartment\n"
+            "      --tolerance SPEC      linear|sigmoid|lagged[,key=value...], e.g.\n"
+            "                            sigmoid,max_factor=2,half_life_days=7\n"
+            "                            (tolerance_model.h; default: original equation)\n"
+            "      --withdrawal SPEC     Model withdrawal episodes: on, or key=value pairs\n"
+            "                            such as onset_delay_days=3,followup_days=14\n"
+            "                            (withdrawal_model.h; default: off)\n"
+            "      --covariate-correlation SPEC\n"
+            "                            Correlate age, weight, bmi, renal and hepatic\n"
+            "                            function: default and/or pairs such as\n"
+            "                            age:renal=-0.6 (covariate_copula.h; default: off)\n"
+            "      --population-cache DIR\n"
+            "                            Map the population from its file in DIR, or\n"
+            "                            generate and store it there (population_cache.h)\n"
+            "\n"
+            "Protocol (default: optimized, 16.17 / 25.31 / 5.07 mg):\n"
+            "      --doses A,B,C         SR-17018 BID, SR-14968 QD, DPP-26 Q6H doses in mg\n"
+            "      --protocol-file PATH  Protocol table or protocol_config.c file\n"
+            "                            (formats in protocol_list.h)\n"
+            "      --protocol NAME       Protocol of --protocol-file to run (default: first)\n"
+            "\n"
+            "Modes (batch kernel):\n"
+            "      --sweep PATH          Run every protocol of a table or protocol_config.c\n"
+            "                            file on one population\n"
+            "      --paired              Common-random-number deltas against the first\n"
+            "                            protocol of the --sweep table\n"
+            "      --sampling MODE       random|stratified|lhs|stratified-lhs\n"
+            "      --allocation-power P  Stratum allocation exponent (default 1)\n"
+            "      --adaptive SPEC       Stop at target CI half-widths, e.g. 0.005 or\n"
+            "                            success=0.005,pain_reduction=0.01\n"
+            "      --chunk N             Stream the population in chunks of N patients\n"
+            "                            with bounded memory; summary statistics only\n"
+            "  -h, --help                Show this help\n",
+            program, N_PATIENTS, SIMULATION_DAYS, SIMULATION_DAYS, TIMESTEPS_PER_DAY, MAX_THREADS);
+}
+
+void sim_config_defaults(SimConfig* c) {
+    memset(c, 0, sizeof(*c));
+    c->n_patients = N_PATIENTS;
+    c->days = SIMULATION_DAYS;
+    c->timesteps_per_day = TIMESTEPS_PER_DAY;
+    c->max_threads = MAX_THREADS;
+    c->seed = DEFAULT_RANDOM_SEED;
+    const Protocol optimized = {
+        .sr17018_dose = 16.17f,  // mg BID
+        .sr14968_dose = 25.31f,  // mg QD
+        .dpp26_dose = 5.07f      // mg Q6H (replacing oxycodone)
+    };
+    dose_schedule_from_protocol(&c->schedule, &optimized);
+    snprintf(c->protocol_name, PROTOCOL_NAME_LEN, "optimized");
+    tolerance_config_defaults(&c->tolerance);
+    withdrawal_config_defaults(&c->withdrawal);
+    covariate_copula_init(&c->copula);
+    c->sampling = SAMPLING_RANDOM;
+    c->allocation_power = 1.0f;
+}
+
+static int parse_int(const char* option, const char* text, int min, int max, int* out) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < min || value > max) {
+        fprintf(stderr, "Error: %s expects an integer in %d..%d, got \"%s\"\n", option, min, max, text);
+        return -1;
+    }
+    *out = (int)value;
+    return 0;
+}
+
+// Standard regimen at the given doses
+static int parse_doses(const char* text, DoseSchedule* schedule) {
+    Protocol protocol;
+    char extra;
+    if (sscanf(text, "%f,%f,%f%c", &protocol.sr17018_dose, &protocol.sr14968_dose,
+               &protocol.dpp26_dose, &extra) != 3 ||
+        protocol.sr17018_dose < 0 || protocol.sr14968_dose < 0 || protocol.dpp26_dose < 0) {
+        fprintf(stderr, "Error: --doses expects three doses >= 0 as A,B,C, got \"%s\"\n", text);
+        return -1;
+    }
+    dose_schedule_from_protocol(schedule, &protocol);
+    return 0;
+}
+
+// Replaces c->schedule with protocol `name` of a protocol table or
+// configuration file (the first one if NULL)
+static int select_protocol(SimConfig* c, const char* path, const char* name) {
+    ProtocolList list;
+    protocol_list_init(&list);
+    if (protocol_list_load(&list, path) != 0) {
+        protocol_list_free(&list);
+        return -1;
+    }
+
+    int found = name ? protocol_list_find(&list, name) : list.n > 0 ? 0 : -1;
+    if (found < 0) {
+        fprintf(stderr, name ? "Error: %s has no protocol named %s\n" : "Error: %s lists no protocols\n",
+                path, name);
+        protocol_list_free(&list);
+        return -1;
+    }
+
+    c->schedule = list.schedules[found];
+    snprintf(c->protocol_name, PROTOCOL_NAME_LEN, "%s", list.names[found]);
+    protocol_list_free(&list);
+    return 0;
+}
+
+int sim_config_parse(SimConfig* c, int argc, char** argv) {
+    const char* protocol_file = NULL;
+    const char* protocol_select = NULL;
+    int doses_given = 0;
+
+    optind = 1;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:d:s:t:c:h", long_options, NULL)) != -1) {
+        int status = 0;
+        switch (opt) {
+            case 'n':
+                status = parse_int("--patients", optarg, 1, INT_MAX, &c->n_patients);
+                break;
+            case 'd':
+                status = parse_int("--days", optarg, 1, SIMULATION_DAYS, &c->days);
+                break;
+            case 's':
+                status = parse_int("--timesteps", optarg, 1, MAX_TIMESTEPS_PER_DAY,
+                                   &c->timesteps_per_day);
+                break;
+            case 't':
+                status = parse_int("--threads", optarg, 1, INT_MAX, &c->max_threads);
+                break;
+            case 'c':
+                c->config_path = optarg;
+                break;
+            case OPT_SEED: {
+                char* end;
+                c->seed = strtoull(optarg, &end, 10);
+                c->seed_given = 1;
+                if (end == optarg || *end != '\0') {
+                    fprintf(stderr, "Error: --seed expects an unsigned integer, got \"%s\"\n", optarg);
+                    status = -1;
+                }
+                break;
+            }
+            case OPT_PROTOCOL_FILE:
+                protocol_file = optarg;
+                break;
+            case OPT_PROTOCOL:
+                protocol_select = optarg;
+                break;
+            case OPT_DOSES:
+                status = parse_doses(optarg, &c->schedule);
+                snprintf(c->protocol_name, PROTOCOL_NAME_LEN, "custom");
+                doses_given = 1;
+                break;
+            case OPT_SWEEP:
+                c->sweep_path = optarg;
+                break;
+            case OPT_PAIRED:
+                c->paired = 1;
+                break;
+            case OPT_SAMPLING:
+                if (sampling_mode_from_name(optarg, &c->sampling) != 0) {
+                    fprintf(stderr, "Error: unknown sampling mode %s\n", optarg);
+                    status = -1;
+                }
+                break;
+            case OPT_ALLOCATION_POWER: {
+                char* end;
+                c->allocation_power = strtof(optarg, &end);
+                if (end == optarg || *end != '\0' || !isfinite(c->allocation_power)) {
+                    fprintf(stderr, "Error: --allocation-power expects a finite number, got \"%s\"\n",
+                            optarg);
+                    status = -1;
+                }
+                break;
+            }
+            case OPT_ADAPTIVE:
+                c->adaptive_spec = optarg;
+                break;
+            case OPT_PK_MODEL:
+                if (pk_model_from_name(optarg, &c->pk_model) != 0) {
+                    fprintf(stderr, "Error: unknown PK model %s (one-compartment or "
+                                    "two-compartment)\n", optarg);
+                    status = -1;
+                }
+                break;
+            case OPT_TOLERANCE:
+                status = tolerance_config_parse(&c->tolerance, optarg);
+                break;
+            case OPT_WITHDRAWAL:
+                status = withdrawal_config_parse(&c->withdrawal, optarg);
+                break;
+            case OPT_POPULATION_CACHE:
+                c->population_cache = optarg;
+                break;
+            case OPT_COVARIATE_CORRELATION:
+                status = covariate_copula_parse(&c->copula, optarg);
+                break;
+            case OPT_CHUNK:
+                status = parse_int("--chunk", optarg, 1, INT_MAX, &c->chunk_patients);
+                break;
+            case 'h':
+                sim_config_usage(stdout, argv[0]);
+                return 1;
+            default:
+                sim_config_usage(stderr, argv[0]);
+                return -1;
+        }
+        if (status != 0) return -1;
+    }
+
+    // A bare argument is the protocol_config.c path, as before the option parser
+    if (optind < argc) c->config_path = argv[optind++];
+    if (optind < argc) {
+        fprintf(stderr, "Error: unexpected argument %s\n", argv[optind]);
+        return -1;
+    }
+
+    if (protocol_select && !protocol_file) {
+        fprintf(stderr, "Error: --protocol selects a row of --protocol-file\n");
+        return -1;
+    }
+    if (protocol_file && doses_given) {
+        fprintf(stderr, "Error: give either --doses or --protocol-file, not both\n");
+        return -1;
+    }
+    if (protocol_file && select_protocol(c, protocol_file, protocol_select) != 0) return -1;
+    return 0;
+}
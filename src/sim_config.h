@@ -0,0 +1,76 @@
+/*
+ * sim_config.h - Run configuration and command line
+ *
+ * The patient_sim.h macros are only defaults now: population size, days,
+ * timesteps per day, thread cap and the protocol all come from the command
+ * line. SIMULATION_DAYS stays the upper bound for --days because it sizes
+ * the daily arrays of TreatmentOutcome and the batch kernel lanes.
+ *
+ * The treatment grid (days x timesteps per day) is run state like the RNG
+ * seed: set once before simulating, read by the kernels and the outcome
+ * records. The batch kernel keeps compile-time specializations for the
+ * common timestep counts (see batch_kernel.c), so the default grid runs at
+ * the same speed as when it was hard-wired.
+ */
+
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#include "patient_sim.h"
+#include "population_gen.h"
+#include "protocol_list.h"
+#include "dose_schedule.h"
+#include "tolerance_model.h"
+#include "withdrawal_model.h"
+#include "covariate_copula.h"
+
+// ============================================================================
+// TREATMENT GRID
+// ============================================================================
+
+// days in [1, SIMULATION_DAYS], timesteps_per_day in [1, 24 * 60];
+// returns 0, or -1 with a message
+int sim_set_grid(int days, int timesteps_per_day);
+int sim_days(void);
+int sim_timesteps_per_day(void);
+
+// ============================================================================
+// COMMAND LINE
+// ============================================================================
+
+typedef struct {
+    int n_patients;
+    int days;
+    int timesteps_per_day;
+    int max_threads;            // Cap on OpenMP threads
+    uint64_t seed;
+    int seed_given;             // --seed overrides random_seed of config_path
+    const char* config_path;    // protocol_config.c-style file, for random_seed
+    DoseSchedule schedule;
+    char protocol_name[PROTOCOL_NAME_LEN];
+    PkModel pk_model;
+    ToleranceConfig tolerance;
+    WithdrawalConfig withdrawal;
+    const char* sweep_path;
+    int paired;
+    SamplingMode sampling;
+    float allocation_power;
+    CovariateCopula copula;
+    const char* adaptive_spec;
+    const char* population_cache;  // Directory of population files (population_cache.h)
+    int chunk_patients;            // Chunked pipeline if > 0 (chunked_pipeline.h)
+} SimConfig;
+
+// patient_sim.h defaults and the optimized protocol
+void sim_config_defaults(SimConfig* c);
+
+/*
+ * Fills c from argv (see sim_config_usage for the options). --protocol-file
+ * is read here, so c->schedule is final on return. Returns 0 to run, 1 if
+ * --help was printed, or -1 with a message.
+ */
+int sim_config_parse(SimConfig* c, int argc, char** argv);
+
+void sim_config_usage(FILE* f, const char* program);
+
+#endif // SIM_CONFIG_H
@@ -0,0 +1,153 @@
+/*
+ * sim_kernel.h - Building blocks shared by the scalar and batch kernels
+ *
+ * Everything here is static inline and branch-light so that it can be
+ * called from inside `#pragma omp simd` lane loops and still vectorize.
+ * The scalar kernel in patient_sim_main.c uses the same functions, which
+ * keeps both execution paths on identical model equations.
+ */
+
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+#include "patient_sim.h"
+#include "simd_math.h"
+#include "outcome_record.h"
+#include "outcome_stats.h"
+#include "dose_schedule.h"
+#include "tolerance_model.h"
+#include "withdrawal_model.h"
+#include <float.h>
+
+// ============================================================================
+// PHARMACOKINETICS
+// ============================================================================
+
+static inline float clearance_factor_from_covariates(float age, float renal_function,
+                                                     float hepatic_function, int cyp2d6_phenotype,
+                                                     float weight) {
+    float cl_factor = 1.0;
+
+    // Age adjustment: 1% reduction per year over 65
+    if (age > 65) {
+        cl_factor *= (1.0 - 0.01 * (age - 65));
+    }
+
+    cl_factor *= renal_function / 90.0;
+    cl_factor *= hepatic_function;
+
+    switch (cyp2d6_phenotype) {
+        case POOR_METABOLIZER:
+            cl_factor *= 0.3;
+            break;
+        case RAPID_METABOLIZER:
+            cl_factor *= 1.5;
+            break;
+        case ULTRA_RAPID_METABOLIZER:
+            cl_factor *= 2.0;
+            break;
+        default:
+            break;
+    }
+
+    // Allometric scaling
+    cl_factor *= powf(weight / 70.0, 0.75);
+
+    return clamp(cl_factor, 0.2, 3.0);
+}
+
+// ============================================================================
+// RECEPTOR DYNAMICS
+// ============================================================================
+
+typedef struct {
+    float mu_receptor_activity;
+    float tolerance_level;
+    float beta_arrestin_signal;
+} ReceptorState;
+
+// tolerance_kind selects the update of tolerance_model.h; pass a constant
+// (or a value fixed for the loop) so the selection stays out of the loop body
+static inline ReceptorState calculate_receptor_dynamics(float sr17018_conc, float sr14968_conc,
+                                                        float dpp26_conc, float tolerance_prev,
+                                                        ToleranceKind tolerance_kind,
+                                                        const ToleranceModel* tolerance) {
+    ReceptorState state = {0};
+
+    // SR-17018: Allosteric modulator, prevents tolerance
+    float sr17018_binding = sr17018_conc / (SR17018.ki_allosteric1 + sr17018_conc);
+    float sr17018_effect = sr17018_binding * SR17018.intrinsic_activity * SR17018.g_protein_bias;
+
+    // SR-14968: High G-protein bias
+    float sr14968_binding = sr14968_conc / (SR14968.ki_allosteric1 + sr14968_conc);
+    float sr14968_effect = sr14968_binding * SR14968.intrinsic_activity * SR14968.g_protein_bias;
+
+    // DPP-26: Orthosteric agonist
+    float dpp26_binding = dpp26_conc / (DPP26.ki_orthosteric + dpp26_conc);
+    float dpp26_effect = dpp26_binding * DPP26.intrinsic_activity;
+
+    // Competitive inhibition between SR compounds (computed unconditionally
+    // and selected, so the lane loop has no control flow)
+    float competition = sr17018_conc / sim_maxf(sr17018_conc + sr14968_conc * 10, FLT_MIN);
+    int competing = sr17018_binding > 0 && sr14968_binding > 0;
+    sr14968_effect *= competing ? (1 - 0.3f * competition) : 1.0f;
+
+    // Total receptor activation, attenuated by tolerance
+    state.mu_receptor_activity = sr17018_effect + sr14968_effect + dpp26_effect;
+    state.mu_receptor_activity /= (1 + tolerance_prev);
+
+    // β-arrestin signaling (leads to tolerance/addiction)
+    state.beta_arrestin_signal = dpp26_binding * DPP26.beta_arrestin_bias +
+                                 sr14968_binding * SR14968.beta_arrestin_bias * 0.1f;
+
+    // Tolerance development
+    float tolerance_rate = DPP26.tolerance_rate * dpp26_binding;
+
+    // SR-17018 reverses tolerance
+    tolerance_rate -= sr17018_binding > 0.3f ? sr17018_binding * 0.02f : 0.0f;
+
+    // The drive is the exposure of the tolerance model
+    state.tolerance_level = tolerance_update(tolerance_kind, tolerance, tolerance_prev,
+                                             tolerance_rate);
+
+    return state;
+}
+
+// ============================================================================
+// ADVERSE EVENTS
+// ============================================================================
+
+// Per-timestep adverse-event probability
+static inline float adverse_event_probability(float beta_arrestin_signal) {
+    return 0.001f * beta_arrestin_signal;
+}
+
+// Bound of adverse_event_probability() over every exposure: binding
+// fractions stay below 1. The kernels sample adverse events by thinning
+// against it (RngThinning).
+static inline float adverse_event_probability_bound(void) {
+    return adverse_event_probability(sim_maxf(DPP26.beta_arrestin_bias, 0) +
+                                     sim_maxf(SR14968.beta_arrestin_bias, 0) * 0.1f);
+}
+
+// ============================================================================
+// OUTCOME FINALIZATION
+// ============================================================================
+
+// Fills the end-of-treatment fields shared by every kernel (patient_sim_main.c)
+void finalize_treatment_outcome(TreatmentOutcome* outcome, float cumulative_analgesia,
+                                float tolerance, float max_beta_arrestin,
+                                int adverse_events, float total_cost, int withdrawal);
+
+// Scalar reference kernel on a dose event table compiled for the run grid;
+// simulate_patient_treatment() runs it on the protocol's standard regimen
+TreatmentOutcome simulate_patient_events(const PatientCharacteristics* p,
+                                         const DoseEventTable* events);
+
+// Scalar reference driver; sink->stats receives the merged per-thread stats
+void simulate_population_streaming(const PatientCharacteristics* patients,
+                                   const DoseSchedule* schedule,
+                                   int n_patients,
+                                   const OutcomeSink* sink);
+
+#endif // SIM_KERNEL_H
@@ -0,0 +1,203 @@
+/*
+ * sim_rng.c - Counter-based reproducible random number generation
+ */
+
+#include "sim_rng.h"
+#include "simd_math.h"
+#include <float.h>
+
+// ============================================================================
+// GLOBAL STATE
+// ============================================================================
+
+static uint64_t run_seed = DEFAULT_RANDOM_SEED;
+
+// Stream used by random_uniform() and friends on this thread
+typedef struct {
+    RngStream stream;
+    int bound;
+    int has_spare;
+    float spare;
+} RngThreadState;
+
+static __thread RngThreadState thread_rng;
+
+// ============================================================================
+// STREAMS
+// ============================================================================
+
+void rng_stream_init(RngStream* s, uint64_t seed, uint32_t patient_id, RngStreamId stream) {
+    s->key[0] = (uint32_t)seed;
+    s->key[1] = (uint32_t)(seed >> 32);
+    s->patient_id = patient_id;
+    s->stream = (uint32_t)stream;
+    s->block = 0;
+    s->buffered = 0;
+}
+
+void rng_stream_seek(RngStream* s, uint64_t draw_index) {
+    s->block = draw_index / 4;
+    s->buffered = 0;
+
+    int skip = (int)(draw_index % 4);
+    if (skip) {
+        rng_next_u32(s);
+        s->buffered = 4 - skip;
+    }
+}
+
+// ============================================================================
+// BULK SAMPLER BANK
+// ============================================================================
+
+void rng_bank_uniform(const RngBank* bank, uint32_t block,
+                      float* u0, float* u1, float* u2, float* u3) {
+    const uint32_t k0 = (uint32_t)bank->seed, k1 = (uint32_t)(bank->seed >> 32);
+    const uint32_t first = bank->first_patient;
+    const uint32_t stream = (uint32_t)bank->stream;
+
+    #pragma omp simd
+    for (int i = 0; i < bank->n; i++) {
+        PhiloxBlock b = philox4x32_10_block(block, 0, first + (uint32_t)i, stream, k0, k1);
+        u0[i] = rng_u32_to_uniform(b.w0);
+        u1[i] = rng_u32_to_uniform(b.w1);
+        u2[i] = rng_u32_to_uniform(b.w2);
+        u3[i] = rng_u32_to_uniform(b.w3);
+    }
+}
+
+void rng_bank_normal(const RngBank* bank, uint32_t block, float* z0, float* z1) {
+    const uint32_t k0 = (uint32_t)bank->seed, k1 = (uint32_t)(bank->seed >> 32);
+    const uint32_t first = bank->first_patient;
+    const uint32_t stream = (uint32_t)bank->stream;
+
+    #pragma omp simd
+    for (int i = 0; i < bank->n; i++) {
+        PhiloxBlock b = philox4x32_10_block(block, 0, first + (uint32_t)i, stream, k0, k1);
+
+        float u = rng_u32_to_uniform(b.w0);
+        float v = rng_u32_to_uniform(b.w1);
+        float mag = sim_sqrtf(-2.0f * sim_logf(u));
+        float sin_v, cos_v;
+        sim_sincos_turns(v, &sin_v, &cos_v);
+        z0[i] = mag * cos_v;
+        z1[i] = mag * sin_v;
+    }
+}
+
+// ============================================================================
+// INDEX PERMUTATIONS
+// ============================================================================
+
+void rng_permutation_init(RngPermutation* p, uint64_t seed, uint32_t id, uint32_t n) {
+    uint32_t bits = 2;
+    while (bits < 32 && (1u << bits) < n) bits += 2;
+
+    p->n = n;
+    p->half_bits = bits / 2;
+    p->half_mask = (1u << p->half_bits) - 1;
+
+    PhiloxBlock k = philox4x32_10_block(0, 0, id, 0xFFFFFFFFu, (uint32_t)seed, (uint32_t)(seed >> 32));
+    p->round_key[0] = k.w0;
+    p->round_key[1] = k.w1;
+    p->round_key[2] = k.w2;
+    p->round_key[3] = k.w3;
+}
+
+// Murmur3 finalizer; a cheap round function is enough for index shuffling
+static inline uint32_t permutation_round(uint32_t x, uint32_t key) {
+    x ^= key;
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+    return x;
+}
+
+uint32_t rng_permute(const RngPermutation* p, uint32_t i) {
+    // Cycle walking: the bit domain is < 4n, so few walks are needed
+    do {
+        uint32_t left = i >> p->half_bits;
+        uint32_t right = i & p->half_mask;
+        for (int r = 0; r < 4; r++) {
+            uint32_t next = left ^ (permutation_round(right, p->round_key[r]) & p->half_mask);
+            left = right;
+            right = next;
+        }
+        i = (left << p->half_bits) | right;
+    } while (i >= p->n);
+    return i;
+}
+
+// ============================================================================
+// RARE EVENTS
+// ============================================================================
+
+void rng_thinning_init(RngThinning* t, float bound) {
+    t->bound = bound;
+    // A zero bound never yields a candidate (log(u) * -inf = +inf); a
+    // bound of 1 makes every step a candidate
+    t->inv_log_miss = bound > 0 ? 1.0 / log1p(-fmin(bound, 1.0f)) : -INFINITY;
+}
+
+// ============================================================================
+// RUN SEED AND THREAD BINDING
+// ============================================================================
+
+void rng_set_seed(uint64_t seed) {
+    run_seed = seed;
+}
+
+uint64_t rng_get_seed(void) {
+    return run_seed;
+}
+
+void rng_bind(uint32_t patient_id, RngStreamId stream) {
+    rng_stream_init(&thread_rng.stream, run_seed, patient_id, stream);
+    thread_rng.bound = 1;
+    thread_rng.has_spare = 0;
+}
+
+// ============================================================================
+// THREAD-BOUND SAMPLERS
+// ============================================================================
+
+static RngStream* bound_stream(void) {
+    if (!thread_rng.bound) {
+        // Callers outside the simulation kernels get a per-thread stream in
+        // patient_id space that no real patient uses
+        rng_bind(UINT32_MAX - (uint32_t)omp_get_thread_num(), RNG_STREAM_POPULATION);
+    }
+    return &thread_rng.stream;
+}
+
+float random_uniform(void) {
+    return rng_uniform(bound_stream());
+}
+
+float random_normal(float mean, float stddev) {
+    RngStream* s = bound_stream();
+
+    if (thread_rng.has_spare) {
+        thread_rng.has_spare = 0;
+        return thread_rng.spare * stddev + mean;
+    }
+
+    thread_rng.has_spare = 1;
+    float u = rng_uniform(s);
+    float v = rng_uniform(s);
+    float mag = sqrtf(-2.0f * logf(u + FLT_MIN));
+    thread_rng.spare = mag * cosf(2.0f * M_PI * v);
+    return mag * sinf(2.0f * M_PI * v) * stddev + mean;
+}
+
+int random_categorical(const float* probs, int n) {
+    float r = random_uniform();
+    float cumsum = 0;
+    for (int i = 0; i < n; i++) {
+        cumsum += probs[i];
+        if (r <= cumsum) return i;
+    }
+    return n - 1;
+}
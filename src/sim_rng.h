@@ -0,0 +1,215 @@
+/*
+ * sim_rng.h - Counter-based reproducible random number generation
+ *
+ * Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+ * 1, 2, 3", SC'11). Every draw is a pure function of
+ *
+ *   key     = run seed (64 bit)
+ *   counter = (draw block, patient_id, stream)
+ *
+ * so a patient's random stream does not depend on which thread simulates
+ * it, on OMP_NUM_THREADS, or on how many patients came before it. Any
+ * shard of the population, or any position inside a stream, can be
+ * reached directly without sequential warm-up.
+ */
+
+#ifndef SIM_RNG_H
+#define SIM_RNG_H
+
+#include "patient_sim.h"
+#include <limits.h>
+#include <stdint.h>
+
+#define DEFAULT_RANDOM_SEED 42
+
+// Independent streams per patient; one per purpose so that draws for one
+// purpose never shift the draws of another
+typedef enum {
+    RNG_STREAM_POPULATION = 0,
+    RNG_STREAM_ADVERSE_EVENTS,
+    RNG_STREAM_ADHERENCE,
+    RNG_N_STREAMS
+} RngStreamId;
+
+// Stream id of `stream` for protocol `protocol` of a multi-protocol sweep;
+// protocol 0 maps to the plain stream id
+static inline RngStreamId rng_protocol_stream(RngStreamId stream, int protocol) {
+    return (RngStreamId)(stream + RNG_N_STREAMS * protocol);
+}
+
+typedef struct {
+    uint32_t key[2];
+    uint32_t patient_id;
+    uint32_t stream;
+    uint64_t block;        // Next counter block to encrypt
+    uint32_t buffer[4];
+    int buffered;          // Unused words left in buffer
+} RngStream;
+
+// ============================================================================
+// PHILOX4x32-10
+// ============================================================================
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+// Words of one encrypted counter block
+typedef struct {
+    uint32_t w0, w1, w2, w3;
+} PhiloxBlock;
+
+// Register form; array-free so it inlines into `omp simd` loops
+static inline PhiloxBlock philox4x32_10_block(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3,
+                                              uint32_t k0, uint32_t k1) {
+    #pragma GCC unroll 10
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    return (PhiloxBlock){c0, c1, c2, c3};
+}
+
+static inline void philox4x32_10(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    PhiloxBlock b = philox4x32_10_block(ctr[0], ctr[1], ctr[2], ctr[3], key[0], key[1]);
+    out[0] = b.w0;
+    out[1] = b.w1;
+    out[2] = b.w2;
+    out[3] = b.w3;
+}
+
+// Maps 32 random bits to the open interval (0, 1), safe for logf()
+static inline float rng_u32_to_uniform(uint32_t x) {
+    return ((float)(x >> 8) + 0.5f) * (1.0f / 16777216.0f);
+}
+
+// ============================================================================
+// STREAMS
+// ============================================================================
+
+void rng_stream_init(RngStream* s, uint64_t seed, uint32_t patient_id, RngStreamId stream);
+
+// Repositions the stream so the next draw is draw number `draw_index`
+void rng_stream_seek(RngStream* s, uint64_t draw_index);
+
+static inline uint32_t rng_next_u32(RngStream* s) {
+    if (s->buffered == 0) {
+        uint32_t ctr[4] = {(uint32_t)s->block, (uint32_t)(s->block >> 32), s->patient_id, s->stream};
+        philox4x32_10(ctr, s->key, s->buffer);
+        s->block++;
+        s->buffered = 4;
+    }
+    return s->buffer[4 - s->buffered--];
+}
+
+static inline float rng_uniform(RngStream* s) {
+    return rng_u32_to_uniform(rng_next_u32(s));
+}
+
+// ============================================================================
+// BULK SAMPLER BANK
+// ============================================================================
+
+/*
+ * Column-wise sampling for patients [first_patient, first_patient + n).
+ * Each call encrypts one Philox block per patient: block `block` of that
+ * patient's stream, i.e. the words a bound stream would return for draws
+ * 4*block .. 4*block+3. Per-patient results are therefore independent of
+ * how the population is split into banks. The loops vectorize.
+ */
+typedef struct {
+    uint64_t seed;
+    RngStreamId stream;
+    uint32_t first_patient;
+    int n;
+} RngBank;
+
+// Four uniform (0, 1) columns per block; all four must be bank->n long
+void rng_bank_uniform(const RngBank* bank, uint32_t block,
+                      float* u0, float* u1, float* u2, float* u3);
+
+// Box-Muller: two independent N(0, 1) columns per block; both are written
+void rng_bank_normal(const RngBank* bank, uint32_t block, float* z0, float* z1);
+
+// ============================================================================
+// INDEX PERMUTATIONS
+// ============================================================================
+
+/*
+ * Keyed pseudo-random permutation of [0, n): a 4-round Feistel network on
+ * the smallest even-width bit domain covering n, cycle-walking back into
+ * range. rng_permute() is a pure function of (seed, id, n, i), so any
+ * range of indices maps independently. Round keys come from the Philox
+ * counter (0, 0, id, 0xFFFFFFFF), which no patient stream reaches.
+ */
+typedef struct {
+    uint32_t n;
+    uint32_t half_bits;
+    uint32_t half_mask;
+    uint32_t round_key[4];
+} RngPermutation;
+
+void rng_permutation_init(RngPermutation* p, uint64_t seed, uint32_t id, uint32_t n);
+uint32_t rng_permute(const RngPermutation* p, uint32_t i);
+
+// ============================================================================
+// RARE EVENTS
+// ============================================================================
+
+/*
+ * Bernoulli trials with a small, time-varying per-step probability
+ * p_t <= bound, sampled by thinning: candidate steps form a Bernoulli(bound)
+ * process whose gaps are drawn directly from the geometric distribution,
+ * and a candidate at step t becomes an event with probability p_t / bound.
+ * Each step is an event with probability exactly p_t, independently, as
+ * with one uniform draw per step, but the stream spends about 2 * bound
+ * draws per step instead of one.
+ *
+ *   int countdown = rng_thinning_gap(&stream, &t);
+ *   for (each step) {
+ *       if (--countdown == 0) {
+ *           events += rng_thinning_accept(&stream, &t, p);
+ *           countdown = rng_thinning_gap(&stream, &t);
+ *       }
+ *   }
+ */
+typedef struct {
+    float bound;           // Upper bound of the per-step probability
+    double inv_log_miss;   // 1 / log(1 - bound)
+} RngThinning;
+
+void rng_thinning_init(RngThinning* t, float bound);
+
+// Steps to the next candidate, >= 1; INT_MAX if the bound is 0
+static inline int rng_thinning_gap(RngStream* s, const RngThinning* t) {
+    double gap = floor(log(rng_uniform(s)) * t->inv_log_miss) + 1;
+    return gap < INT_MAX ? (int)gap : INT_MAX;
+}
+
+// Whether the candidate at a step with probability p is an event
+static inline int rng_thinning_accept(RngStream* s, const RngThinning* t, float p) {
+    return rng_uniform(s) * t->bound < p;
+}
+
+// ============================================================================
+// RUN SEED AND THREAD BINDING
+// ============================================================================
+
+void rng_set_seed(uint64_t seed);
+uint64_t rng_get_seed(void);
+
+// Points random_uniform()/random_normal()/random_categorical() on the
+// calling thread at (run seed, patient_id, stream), starting at draw 0
+void rng_bind(uint32_t patient_id, RngStreamId stream);
+
+#endif // SIM_RNG_H
@@ -0,0 +1,119 @@
+/*
+ * simd_math.h - Vectorizable float math for `#pragma omp simd` loops
+ *
+ * libm calls block loop vectorization unless glibc's libmvec variants are
+ * enabled (-ffast-math). These branch-free Cephes-style replacements
+ * inline into lane loops instead. Relative errors are a few ulp on the
+ * stated domains, which are not range-checked.
+ */
+
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+
+// fmaxf/fminf carry NaN semantics that block vectorization without -ffast-math
+static inline float sim_maxf(float a, float b) { return a > b ? a : b; }
+static inline float sim_minf(float a, float b) { return a < b ? a : b; }
+
+static inline float sim_as_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline uint32_t sim_as_uint(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+/*
+ * expf(), x in [-87, 88]. Cody-Waite range reduction plus the degree-6
+ * Cephes polynomial; max relative error below 2e-7. The domain is not
+ * clamped: a clamp lets the compiler thread the saturated case into a
+ * branch, which blocks if-conversion.
+ */
+static inline float sim_expf(float x) {
+    float t = x * 1.44269504088896341f;
+    float n = (float)(int32_t)(t + (t >= 0 ? 0.5f : -0.5f));  // round to nearest
+    float r = x - n * 0.693359375f + n * 2.12194440e-4f;
+
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.0f;
+
+    return p * sim_as_float((uint32_t)((int32_t)n + 127) << 23);
+}
+
+/*
+ * logf(), x a positive normal float. Mantissa reduced to [sqrt(0.5), sqrt(2))
+ * and fed to the Cephes degree-8 polynomial; max relative error below 3e-7.
+ */
+static inline float sim_logf(float x) {
+    uint32_t bits = sim_as_uint(x);
+    float e = (float)((int32_t)((bits >> 23) & 0xff) - 126);
+    float m = sim_as_float((bits & 0x807fffffu) | 0x3f000000u);  // [0.5, 1)
+
+    int small = m < 0.707106781186547524f;
+    e = small ? e - 1.0f : e;
+    m = small ? m + m - 1.0f : m - 1.0f;
+
+    float z = m * m;
+    float y = 7.0376836292e-2f;
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y = y * m * z;
+
+    y += -2.12194440e-4f * e;
+    y += -0.5f * z;
+    return m + y + 0.693359375f * e;
+}
+
+/*
+ * sqrtf(), x a positive normal float. sqrtf() itself only vectorizes with
+ * -fno-math-errno; this is the bit-level reciprocal square root estimate
+ * refined by three Newton steps, relative error below 2e-7.
+ */
+static inline float sim_sqrtf(float x) {
+    float y = sim_as_float(0x5f3759dfu - (sim_as_uint(x) >> 1));
+    float half_x = 0.5f * x;
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    return x * y;
+}
+
+/*
+ * sin(2*pi*v) and cos(2*pi*v) for v in [0, 1). Works in turns, so the
+ * quadrant reduction is exact; the Cephes sinf/cosf polynomials on
+ * [-pi/4, pi/4] give max absolute error below 1e-7.
+ */
+static inline void sim_sincos_turns(float v, float* sin_out, float* cos_out) {
+    float q = (float)(int32_t)(v * 4.0f + 0.5f);
+    int quadrant = (int32_t)q & 3;
+    float a = (v - q * 0.25f) * 6.28318530717958647f;  // [-pi/4, pi/4]
+    float a2 = a * a;
+
+    float s = ((-1.9515295891e-4f * a2 + 8.3321608736e-3f) * a2 - 1.6666654611e-1f) * a2 * a + a;
+    float c = ((2.443315711809948e-5f * a2 - 1.388731625493765e-3f) * a2 + 4.166664568298827e-2f) * a2 * a2
+              - 0.5f * a2 + 1.0f;
+
+    float sin_v = (quadrant & 1) ? c : s;
+    float cos_v = (quadrant & 1) ? s : c;
+    *sin_out = (quadrant == 2 || quadrant == 3) ? -sin_v : sin_v;
+    *cos_out = (quadrant == 1 || quadrant == 2) ? -cos_v : cos_v;
+}
+
+#endif // SIMD_MATH_H
@@ -0,0 +1,129 @@
+/*
+ * tolerance_model.c - Tolerance progression models for the native kernels
+ */
+
+#include "tolerance_model.h"
+
+static ToleranceConfig run_config = {
+    .kind = TOLERANCE_LINEAR,
+    .slope = 0.01f,
+    .max_factor = INFINITY,
+    .half_life_days = 14.0f,
+    .rise_tau = 7.0f,
+    .decay_tau = 10.0f,
+    .per_timestep = 1
+};
+
+void tolerance_config_defaults(ToleranceConfig* c) {
+    tolerance_config_for_kind(c, TOLERANCE_LINEAR);
+    c->max_factor = INFINITY;
+    c->per_timestep = 1;
+}
+
+void tolerance_config_for_kind(ToleranceConfig* c, ToleranceKind kind) {
+    c->kind = kind;
+    c->slope = 0.01f;
+    c->max_factor = 3.0f;
+    c->half_life_days = 14.0f;
+    c->rise_tau = 7.0f;
+    c->decay_tau = 10.0f;
+    c->per_timestep = 0;
+}
+
+int tolerance_kind_from_name(const char* name, ToleranceKind* kind) {
+    if (strcmp(name, "linear") == 0) {
+        *kind = TOLERANCE_LINEAR;
+    } else if (strcmp(name, "sigmoid") == 0) {
+        *kind = TOLERANCE_SIGMOID;
+    } else if (strcmp(name, "lagged") == 0) {
+        *kind = TOLERANCE_LAGGED;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* tolerance_kind_name(ToleranceKind kind) {
+    static const char* const names[TOLERANCE_N_MODELS] = {"linear", "sigmoid", "lagged"};
+    return kind < TOLERANCE_N_MODELS ? names[kind] : "unknown";
+}
+
+int tolerance_config_parse(ToleranceConfig* c, const char* spec) {
+    char buffer[256];
+    if (snprintf(buffer, sizeof(buffer), "%s", spec) >= (int)sizeof(buffer)) {
+        fprintf(stderr, "Error: tolerance spec is longer than %d characters\n",
+                (int)sizeof(buffer) - 1);
+        return -1;
+    }
+
+    char* item = strtok(buffer, ",");
+    ToleranceKind kind;
+    if (!item || tolerance_kind_from_name(item, &kind) != 0) {
+        fprintf(stderr, "Error: --tolerance expects linear, sigmoid or lagged first, got \"%s\"\n",
+                spec);
+        return -1;
+    }
+    tolerance_config_for_kind(c, kind);
+
+    while ((item = strtok(NULL, ","))) {
+        char* eq = strchr(item, '=');
+        char* end = NULL;
+        float value = eq ? strtof(eq + 1, &end) : 0;
+        if (!eq || end == eq + 1 || *end != '\0') {
+            fprintf(stderr, "Error: bad tolerance parameter \"%s\" (expected key=value)\n", item);
+            return -1;
+        }
+
+        *eq = '\0';
+        float* field = strcmp(item, "slope") == 0 ? &c->slope
+                     : strcmp(item, "max_factor") == 0 ? &c->max_factor
+                     : strcmp(item, "half_life_days") == 0 ? &c->half_life_days
+                     : strcmp(item, "rise_tau") == 0 ? &c->rise_tau
+                     : strcmp(item, "decay_tau") == 0 ? &c->decay_tau
+                     : NULL;
+        if (!field) {
+            fprintf(stderr, "Error: unknown tolerance parameter \"%s\" (slope, max_factor, "
+                            "half_life_days, rise_tau, decay_tau)\n", item);
+            return -1;
+        }
+        if (!isfinite(value) || value < 0 || (field == &c->max_factor && value == 0)) {
+            fprintf(stderr, "Error: tolerance parameter %s must be %s\n", item,
+                    field == &c->max_factor ? "finite and positive" : "finite and non-negative");
+            return -1;
+        }
+        *field = value;
+    }
+    return 0;
+}
+
+void tolerance_model_init(ToleranceModel* m, const ToleranceConfig* c, float dt_days) {
+    // Time constants have the same floor as tolerance_models.py
+    double half_life = fmax(c->half_life_days, 1e-3);
+    double rise_tau = fmax(c->rise_tau, 1e-3);
+    double decay_tau = fmax(c->decay_tau, 1e-3);
+
+    memset(m, 0, sizeof(*m));
+    m->kind = c->kind;
+    m->ceiling = c->max_factor;
+    switch (c->kind) {
+        case TOLERANCE_SIGMOID:
+            m->k = (float)(log(2.0) / half_life);
+            m->approach = (float)(1.0 - exp(-log(2.0) / half_life * dt_days));
+            break;
+        case TOLERANCE_LAGGED:
+            m->approach = (float)(1.0 - exp(-dt_days / rise_tau));
+            m->recovery = (float)(1.0 - exp(-dt_days / decay_tau));
+            break;
+        default:
+            m->increment = c->per_timestep ? c->slope : (float)((double)c->slope * dt_days);
+            break;
+    }
+}
+
+void tolerance_set_config(const ToleranceConfig* c) {
+    run_config = *c;
+}
+
+const ToleranceConfig* tolerance_config(void) {
+    return &run_config;
+}
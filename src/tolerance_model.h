@@ -0,0 +1,122 @@
+/*
+ * tolerance_model.h - Tolerance progression models for the native kernels
+ *
+ * Native ports of the models in tolerance_models.py, with the same
+ * parameters and defaults as make_tolerance_model():
+ *
+ *   linear   level += slope * exposure * dt, capped at max_factor
+ *   sigmoid  level relaxes towards max_factor * (1 - exp(-k * exposure))
+ *            with k = ln 2 / half_life_days
+ *   lagged   level rises towards max_factor with time constant rise_tau
+ *            while exposed, decays towards 0 with decay_tau otherwise
+ *
+ * Levels stay in [0, max_factor] in both implementations. In the kernels
+ * the exposure of a timestep is the tolerance drive of
+ * calculate_receptor_dynamics() (DPP-26 binding times its tolerance rate,
+ * less the SR-17018 reversal, so it can be negative) and dt is the
+ * timestep in days. tests/data/tolerance_vectors.c writes the reference
+ * levels that tests/test_tolerance_vectors.py checks the Python models
+ * against.
+ *
+ * Without --tolerance the kernels keep their original equation: linear at
+ * 0.01 per timestep, no ceiling (tolerance_config_defaults).
+ *
+ * The model is a run setting. tolerance_model_init() folds the parameters
+ * and the timestep into per-step coefficients once, and the kernels select
+ * the update outside the timestep loop; the batch kernel has one instance
+ * per model, so the lane loop calls the update inline with no dispatch.
+ */
+
+#ifndef TOLERANCE_MODEL_H
+#define TOLERANCE_MODEL_H
+
+#include "patient_sim.h"
+#include "simd_math.h"
+
+typedef enum {
+    TOLERANCE_LINEAR = 0,
+    TOLERANCE_SIGMOID,
+    TOLERANCE_LAGGED,
+    TOLERANCE_N_MODELS
+} ToleranceKind;
+
+// Parameters as in tolerance_models.py; times in days
+typedef struct {
+    ToleranceKind kind;
+    float slope;            // linear, per day (per timestep if per_timestep)
+    float max_factor;       // Ceiling of every model
+    float half_life_days;   // sigmoid
+    float rise_tau;         // lagged
+    float decay_tau;        // lagged
+    int per_timestep;       // linear slope applies per timestep (original kernels)
+} ToleranceConfig;
+
+// Per-step coefficients for one timestep length
+typedef struct {
+    ToleranceKind kind;
+    float increment;  // linear: slope * dt
+    float ceiling;
+    float k;          // sigmoid: ln 2 / half_life_days
+    float approach;   // sigmoid: 1 - exp(-k dt); lagged: 1 - exp(-dt / rise_tau)
+    float recovery;   // lagged: 1 - exp(-dt / decay_tau)
+} ToleranceModel;
+
+// The original kernel equation: linear, 0.01 per timestep, no ceiling
+void tolerance_config_defaults(ToleranceConfig* c);
+
+// make_tolerance_model() defaults for a model
+void tolerance_config_for_kind(ToleranceConfig* c, ToleranceKind kind);
+
+/*
+ * Parses "MODEL[,key=value...]" with the make_tolerance_model() keys, e.g.
+ *
+ *   sigmoid,max_factor=2,half_life_days=7
+ *   lagged,rise_tau=5,decay_tau=12
+ *   linear,slope=0.02
+ *
+ * Returns 0, or -1 with a message.
+ */
+int tolerance_config_parse(ToleranceConfig* c, const char* spec);
+
+// "linear", "sigmoid" or "lagged"; returns 0, or -1 if not recognized
+int tolerance_kind_from_name(const char* name, ToleranceKind* kind);
+const char* tolerance_kind_name(ToleranceKind kind);
+
+void tolerance_model_init(ToleranceModel* m, const ToleranceConfig* c, float dt_days);
+
+// Run setting read by the kernels; tolerance_config_defaults() until set
+void tolerance_set_config(const ToleranceConfig* c);
+const ToleranceConfig* tolerance_config(void);
+
+// ============================================================================
+// UPDATES
+// ============================================================================
+
+// Branch-free so they vectorize inside lane loops
+
+static inline float tolerance_update_linear(const ToleranceModel* m, float level, float exposure) {
+    return sim_minf(sim_maxf(0, level + exposure * m->increment), m->ceiling);
+}
+
+static inline float tolerance_update_sigmoid(const ToleranceModel* m, float level, float exposure) {
+    float target = m->ceiling * (1.0f - sim_expf(-m->k * exposure));
+    return sim_minf(sim_maxf(0, level + (target - level) * m->approach), m->ceiling);
+}
+
+static inline float tolerance_update_lagged(const ToleranceModel* m, float level, float exposure) {
+    float delta = exposure > 0 ? (m->ceiling - level) * m->approach : -level * m->recovery;
+    return sim_minf(sim_maxf(0, level + delta), m->ceiling);
+}
+
+// kind is a compile-time constant in the batch kernel instances, so the
+// switch folds away there
+static inline float tolerance_update(ToleranceKind kind, const ToleranceModel* m, float level,
+                                     float exposure) {
+    switch (kind) {
+        case TOLERANCE_SIGMOID: return tolerance_update_sigmoid(m, level, exposure);
+        case TOLERANCE_LAGGED: return tolerance_update_lagged(m, level, exposure);
+        default: return tolerance_update_linear(m, level, exposure);
+    }
+}
+
+#endif // TOLERANCE_MODEL_H
@@ -34,7 +34,7 @@ class LinearTolerance(ToleranceModel):
 
     def update(self, state: ToleranceState, exposure: float, dt_days: float) -> ToleranceState:
         increment = self.slope * exposure * dt_days
-        state.level = min(state.level + increment, self.ceiling)
+        state.level = max(0.0, min(state.level + increment, self.ceiling))
         state.ceiling = self.ceiling
         return state
 
@@ -0,0 +1,155 @@
+/*
+ * trace_store.c - Optional per-patient daily pain/analgesia traces
+ */
+
+#include "trace_store.h"
+#include <sys/mman.h>
+
+// ============================================================================
+// PER-THREAD CHUNKS
+// ============================================================================
+
+static atomic_uint_fast64_t next_store_id = 1;
+
+// Unused remainder of the calling thread's current chunk
+static __thread struct {
+    uint64_t store_id;
+    size_t next;
+    size_t end;
+} chunk;
+
+static size_t element_size(TraceFormat format) {
+    return format == TRACE_FLOAT32 ? 4 : format == TRACE_UINT16 ? 2 : 1;
+}
+
+// Returns the first of count consecutive elements, or SIZE_MAX when full
+static size_t claim_elements(TraceStore* store, size_t count) {
+    if (chunk.store_id != store->id || chunk.end - chunk.next < count) {
+        size_t size = count > TRACE_CHUNK_ELEMENTS ? count : TRACE_CHUNK_ELEMENTS;
+        size_t start = atomic_fetch_add_explicit(&store->claimed, size, memory_order_relaxed);
+        if (start + size > store->capacity) return SIZE_MAX;
+
+        chunk.store_id = store->id;
+        chunk.next = start;
+        chunk.end = start + size;
+    }
+
+    size_t first = chunk.next;
+    chunk.next += count;
+    return first;
+}
+
+// ============================================================================
+// QUANTIZATION
+// ============================================================================
+
+static void encode(TraceFormat format, void* dst, const float* src, int n, float range) {
+    if (format == TRACE_FLOAT32) {
+        memcpy(dst, src, n * sizeof(float));
+    } else if (format == TRACE_UINT16) {
+        uint16_t* out = (uint16_t*)dst;
+        for (int d = 0; d < n; d++) {
+            out[d] = (uint16_t)(clamp(src[d] / range, 0, 1) * 65535.0f + 0.5f);
+        }
+    } else {
+        uint8_t* out = (uint8_t*)dst;
+        for (int d = 0; d < n; d++) {
+            out[d] = (uint8_t)(clamp(src[d] / range, 0, 1) * 255.0f + 0.5f);
+        }
+    }
+}
+
+static void decode(TraceFormat format, float* dst, const void* src, int n, float range) {
+    if (format == TRACE_FLOAT32) {
+        memcpy(dst, src, n * sizeof(float));
+    } else if (format == TRACE_UINT16) {
+        const uint16_t* in = (const uint16_t*)src;
+        for (int d = 0; d < n; d++) dst[d] = in[d] * (range / 65535.0f);
+    } else {
+        const uint8_t* in = (const uint8_t*)src;
+        for (int d = 0; d < n; d++) dst[d] = in[d] * (range / 255.0f);
+    }
+}
+
+// ============================================================================
+// STORE
+// ============================================================================
+
+TraceStore* trace_store_create(int n_patients, TraceFormat format) {
+    if (format != TRACE_FLOAT32 && format != TRACE_UINT16 && format != TRACE_UINT8) return NULL;
+
+    TraceStore* store = (TraceStore*)calloc(1, sizeof(TraceStore));
+    if (!store) return NULL;
+
+    store->format = format;
+    store->n_patients = n_patients;
+    store->id = atomic_fetch_add(&next_store_id, 1);
+    store->offset = (uint64_t*)calloc(n_patients, sizeof(uint64_t));
+    store->days = (uint16_t*)calloc(n_patients, sizeof(uint16_t));
+
+    // Worst case plus one partly used chunk per possible thread; untouched
+    // pages of the reservation never get backed by memory
+    size_t worst = (size_t)n_patients * 2 * SIMULATION_DAYS;
+    store->capacity = worst + worst / 4 + (size_t)(omp_get_max_threads() + 1) * TRACE_CHUNK_ELEMENTS;
+    void* arena = mmap(NULL, store->capacity * element_size(format), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (!store->offset || !store->days || arena == MAP_FAILED) {
+        if (arena != MAP_FAILED) munmap(arena, store->capacity * element_size(format));
+        free(store->offset);
+        free(store->days);
+        free(store);
+        return NULL;
+    }
+
+    store->arena = (uint8_t*)arena;
+    atomic_init(&store->claimed, 0);
+    atomic_init(&store->failed, 0);
+    return store;
+}
+
+void trace_store_destroy(TraceStore* store) {
+    if (!store) return;
+    munmap(store->arena, store->capacity * element_size(store->format));
+    free(store->offset);
+    free(store->days);
+    free(store);
+}
+
+int trace_store_put(TraceStore* store, int i, const float* pain, const float* analgesia, int days) {
+    size_t first = claim_elements(store, 2 * (size_t)days);
+    if (first == SIZE_MAX) {
+        atomic_fetch_add_explicit(&store->failed, 1, memory_order_relaxed);
+        return -1;
+    }
+
+    size_t size = element_size(store->format);
+    encode(store->format, store->arena + first * size, pain, days, TRACE_PAIN_MAX);
+    encode(store->format, store->arena + (first + days) * size, analgesia, days, TRACE_ANALGESIA_MAX);
+
+    store->offset[i] = first;
+    store->days[i] = (uint16_t)days;
+    return 0;
+}
+
+long trace_store_failures(const TraceStore* store) {
+    return atomic_load(&store->failed);
+}
+
+int trace_store_get(const TraceStore* store, int i, float* pain, float* analgesia) {
+    int days = store->days[i];
+    size_t size = element_size(store->format);
+    size_t first = store->offset[i];
+
+    decode(store->format, pain, store->arena + first * size, days, TRACE_PAIN_MAX);
+    decode(store->format, analgesia, store->arena + (first + days) * size, days, TRACE_ANALGESIA_MAX);
+    return days;
+}
+
+size_t trace_store_bytes_used(const TraceStore* store) {
+    size_t elements = 0;
+    for (int i = 0; i < store->n_patients; i++) {
+        elements += 2 * (size_t)store->days[i];
+    }
+    return elements * element_size(store->format);
+}
@@ -0,0 +1,61 @@
+/*
+ * trace_store.h - Optional per-patient daily pain/analgesia traces
+ *
+ * Each patient's trace covers only the days actually simulated (up to and
+ * including the discontinuation day), stored back to back in one arena.
+ * The arena is reserved for the worst case but only the pages written are
+ * backed by memory. Workers carve per-thread chunks out of the arena, so
+ * appending a trace needs no shared-counter traffic per patient.
+ *
+ * Values can be kept as float or quantized to 16 or 8 bits over fixed
+ * ranges: pain [0, 10], analgesia [0, TRACE_ANALGESIA_MAX]. Resolution is
+ * range / 65535 or range / 255 (0.04 pain points at 8 bits).
+ */
+
+#ifndef TRACE_STORE_H
+#define TRACE_STORE_H
+
+#include "patient_sim.h"
+#include <stdatomic.h>
+
+#define TRACE_PAIN_MAX 10.0f
+#define TRACE_ANALGESIA_MAX 2.0f
+#define TRACE_CHUNK_ELEMENTS (1 << 16)  // Elements claimed from the arena at once
+
+typedef enum {
+    TRACE_FLOAT32 = 32,
+    TRACE_UINT16 = 16,
+    TRACE_UINT8 = 8
+} TraceFormat;
+
+typedef struct {
+    TraceFormat format;
+    int n_patients;
+    uint64_t id;            // Distinguishes stores for the per-thread chunk cursors
+    uint64_t* offset;       // First element of each patient's trace
+    uint16_t* days;         // Days recorded per patient (0 = none)
+    uint8_t* arena;         // Pain days then analgesia days, per patient
+    size_t capacity;        // Elements reserved
+    atomic_size_t claimed;  // Elements handed out to thread chunks
+    atomic_long failed;     // Patients whose trace did not fit
+} TraceStore;
+
+// Returns NULL on failure; format must be one of TraceFormat
+TraceStore* trace_store_create(int n_patients, TraceFormat format);
+void trace_store_destroy(TraceStore* store);
+
+// Records days entries of pain and analgesia for patient i; 0 on success,
+// -1 (counted in trace_store_failures) if the arena is exhausted, which
+// leaves the patient with no trace
+int trace_store_put(TraceStore* store, int i, const float* pain, const float* analgesia, int days);
+
+// Patients trace_store_put could not store
+long trace_store_failures(const TraceStore* store);
+
+// Dequantizes patient i's trace; returns the number of days written
+int trace_store_get(const TraceStore* store, int i, float* pain, float* analgesia);
+
+// Bytes of trace data actually written (for reporting)
+size_t trace_store_bytes_used(const TraceStore* store);
+
+#endif // TRACE_STORE_H
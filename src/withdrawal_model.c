@@ -0,0 +1,77 @@
+/*
+ * withdrawal_model.c - Event-driven withdrawal episodes
+ */
+
+#include "withdrawal_model.h"
+
+static WithdrawalConfig run_config = {
+    .enabled = 0,
+    .onset_delay_days = 2.0f,
+    .severity_scale = 1.0f,
+    .exposure_threshold = 0.05f,
+    .severity_threshold = 0.1f,
+    .followup_days = 7.0f
+};
+
+void withdrawal_config_defaults(WithdrawalConfig* c) {
+    c->enabled = 0;
+    c->onset_delay_days = 2.0f;
+    c->severity_scale = 1.0f;
+    c->exposure_threshold = 0.05f;
+    c->severity_threshold = 0.1f;
+    c->followup_days = 7.0f;
+}
+
+int withdrawal_config_parse(WithdrawalConfig* c, const char* spec) {
+    c->enabled = 1;
+    if (strcmp(spec, "on") == 0) return 0;
+
+    char buffer[256];
+    if (snprintf(buffer, sizeof(buffer), "%s", spec) >= (int)sizeof(buffer)) {
+        fprintf(stderr, "Error: withdrawal spec is longer than %d characters\n",
+                (int)sizeof(buffer) - 1);
+        return -1;
+    }
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        char* end = NULL;
+        float value = eq ? strtof(eq + 1, &end) : 0;
+        if (!eq || end == eq + 1 || *end != '\0' || !isfinite(value) || value < 0) {
+            fprintf(stderr, "Error: bad withdrawal parameter \"%s\" (expected key=value, "
+                            "finite value >= 0)\n", item);
+            return -1;
+        }
+
+        *eq = '\0';
+        // Every severity reaches a zero threshold
+        if (strcmp(item, "severity_threshold") == 0 && value == 0) {
+            fprintf(stderr, "Error: withdrawal parameter severity_threshold must be positive\n");
+            return -1;
+        }
+        if (strcmp(item, "onset_delay_days") == 0) {
+            c->onset_delay_days = value;
+        } else if (strcmp(item, "severity_scale") == 0) {
+            c->severity_scale = value;
+        } else if (strcmp(item, "exposure_threshold") == 0) {
+            c->exposure_threshold = value;
+        } else if (strcmp(item, "severity_threshold") == 0) {
+            c->severity_threshold = value;
+        } else if (strcmp(item, "followup_days") == 0) {
+            c->followup_days = value;
+        } else {
+            fprintf(stderr, "Error: unknown withdrawal parameter \"%s\" (onset_delay_days, "
+                            "severity_scale, exposure_threshold, severity_threshold, "
+                            "followup_days)\n", item);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void withdrawal_set_config(const WithdrawalConfig* c) {
+    run_config = *c;
+}
+
+const WithdrawalConfig* withdrawal_config(void) {
+    return &run_config;
+}
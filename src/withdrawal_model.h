@@ -0,0 +1,105 @@
+/*
+ * withdrawal_model.h - Event-driven withdrawal episodes
+ *
+ * Native counterpart of SimpleWithdrawal in tolerance_models.py. Once a
+ * patient has been abstinent for longer than onset_delay_days, severity
+ * rises by 0.05 * severity_scale per day, up to 1. Here the rise is also
+ * scaled by physical dependence (the tolerance level) and by the share of
+ * receptors SR-17018 leaves unprotected (prevents_withdrawal).
+ *
+ * Nothing is integrated per timestep. Within a day the severity is a
+ * closed-form function of the abstinent days, so the kernels only look at
+ * exposure at two kinds of events:
+ *   - day boundaries, where DPP-26 is at its trough before the next dose;
+ *     a patient whose occupancy is below exposure_threshold counts as
+ *     abstinent for that day, and exposure above it ends the episode
+ *   - the end of treatment (completion or discontinuation), after which
+ *     dosing stops and the episode runs for followup_days
+ * A patient has withdrawal if severity reaches severity_threshold.
+ *
+ * Disabled unless --withdrawal is given, so runs without it report no
+ * withdrawal, as before.
+ */
+
+#ifndef WITHDRAWAL_MODEL_H
+#define WITHDRAWAL_MODEL_H
+
+#include "patient_sim.h"
+#include "simd_math.h"
+
+typedef struct {
+    int enabled;
+    float onset_delay_days;    // SimpleWithdrawal parameters
+    float severity_scale;
+    float exposure_threshold;  // DPP-26 receptor occupancy counted as abstinence
+    float severity_threshold;  // Severity counted as withdrawal
+    float followup_days;       // Abstinence observed after the last dose
+} WithdrawalConfig;
+
+// Disabled; SimpleWithdrawal defaults (onset 2 days, scale 1), occupancy
+// threshold 0.05, severity threshold 0.1, 7 days of follow-up
+void withdrawal_config_defaults(WithdrawalConfig* c);
+
+/*
+ * Enables the model and parses optional comma-separated key=value pairs:
+ * onset_delay_days, severity_scale, exposure_threshold, severity_threshold
+ * and followup_days, e.g. "on" or "onset_delay_days=3,followup_days=14".
+ * Values must be finite and non-negative, severity_threshold positive.
+ * Returns 0, or -1 with a message.
+ */
+int withdrawal_config_parse(WithdrawalConfig* c, const char* spec);
+
+// Run setting read by the kernels; disabled until set
+void withdrawal_set_config(const WithdrawalConfig* c);
+const WithdrawalConfig* withdrawal_config(void);
+
+// DPP-26 receptor occupancy, the exposure measure
+static inline float withdrawal_exposure(float dpp26_conc) {
+    return dpp26_conc / (DPP26.ki_orthosteric + dpp26_conc);
+}
+
+// Severity rise per abstinent day after the onset delay, from the current
+// dependence and SR-17018 level
+static inline float withdrawal_rate(const WithdrawalConfig* c, float dependence,
+                                    float sr17018_conc) {
+    float protection = SR17018.prevents_withdrawal
+                           ? sr17018_conc / (SR17018.ki_allosteric1 + sr17018_conc)
+                           : 0.0f;
+    return 0.05f * c->severity_scale * sim_maxf(dependence, 0) * (1.0f - protection);
+}
+
+// Whether an episode of abstinent_days at rate reaches the threshold
+static inline int withdrawal_reached(const WithdrawalConfig* c, float rate, float abstinent_days) {
+    float severity = sim_minf(1.0f, rate * sim_maxf(abstinent_days - c->onset_delay_days, 0));
+    return severity >= c->severity_threshold;
+}
+
+// Per-patient episode state
+typedef struct {
+    int abstinent_days;  // Of the current episode, 0 if exposed
+    int occurred;
+} WithdrawalEpisode;
+
+// Day boundary: DPP-26 is at its trough. Concentrations are central
+// amounts; dependence is the tolerance level.
+static inline void withdrawal_day_boundary(const WithdrawalConfig* c, WithdrawalEpisode* e,
+                                           float dpp26_conc, float sr17018_conc,
+                                           float dependence) {
+    if (withdrawal_exposure(dpp26_conc) >= c->exposure_threshold) {
+        e->abstinent_days = 0;
+        return;
+    }
+    e->abstinent_days++;
+    e->occurred |= withdrawal_reached(c, withdrawal_rate(c, dependence, sr17018_conc),
+                                      e->abstinent_days);
+}
+
+// End of treatment: dosing stops, and the episode (continuing one if the
+// patient was already abstinent) runs through the follow-up
+static inline void withdrawal_end_of_treatment(const WithdrawalConfig* c, WithdrawalEpisode* e,
+                                               float sr17018_conc, float dependence) {
+    e->occurred |= withdrawal_reached(c, withdrawal_rate(c, dependence, sr17018_conc),
+                                      e->abstinent_days + c->followup_days);
+}
+
+#endif // WITHDRAWAL_MODEL_H
@@ -0,0 +1,91 @@
+/*
+ * tolerance_vectors.c - Writes tolerance_vectors.json from the native models
+ *
+ * Runs each case through tolerance_update() of src/tolerance_model.h,
+ * starting at level 0, and prints the JSON that
+ * tests/test_tolerance_vectors.py checks tolerance_models.py against.
+ * Regenerate after changing either implementation or the cases below:
+ *
+ *   gcc -O2 -Isrc tests/data/tolerance_vectors.c src/tolerance_model.c -lm \
+ *       -o tolerance_vectors && ./tolerance_vectors > tests/data/tolerance_vectors.json
+ */
+
+#include "tolerance_model.h"
+
+#define MAX_STEPS 16
+
+typedef struct {
+    const char* spec;  // tolerance_config_parse() spec, also written as the JSON config
+    float dt_days;
+    int n;
+    float exposure[MAX_STEPS];
+} VectorCase;
+
+static const VectorCase CASES[] = {
+    {"linear", 1, 8, {10, 50, 50, 0, 100, 100, 20, 5}},
+    {"linear,slope=0.05,max_factor=1.5", 0.5f, 8, {4, 4, 8, 0, 16, 16, 16, 2}},
+    // Negative drive (SR-17018 reversal above DPP-26 tolerance) floors at 0
+    {"linear,slope=0.02", 1, 8, {50, -20, -80, 30, -10, 0, 100, -5}},
+    {"sigmoid", 1, 8, {10, 10, 10, 10, 0, 0, 25, 25}},
+    {"sigmoid,max_factor=2.0,half_life_days=7", 7, 6, {10, 10, 3, 0, 40, 40}},
+    {"sigmoid,half_life_days=3", 0.25f, 8, {0.5f, 1, 2, 4, 8, 0.2f, 0, 0}},
+    {"lagged", 1, 10, {1, 1, 1, 1, 1, 0, 0, 0, 1, 0}},
+    {"lagged,rise_tau=3,decay_tau=12,max_factor=2.0", 2, 8, {0.1f, 0.1f, 0.1f, 0, 0, 0.5f, 0, 0}},
+};
+
+#define N_CASES ((int)(sizeof(CASES) / sizeof(CASES[0])))
+
+// "linear,slope=0.05" -> {"model": "linear", "slope": 0.05}
+static void print_config(const char* spec) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", spec);
+    int first = 1;
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        if (first) {
+            printf("{\"model\": \"%s\"", item);
+        } else {
+            *eq = '\0';
+            printf(", \"%s\": %s", item, eq + 1);
+        }
+        first = 0;
+    }
+    printf("}");
+}
+
+static void print_values(const float* values, int n) {
+    printf("[");
+    for (int i = 0; i < n; i++) printf("%s%.7g", i ? ", " : "", values[i]);
+    printf("]");
+}
+
+int main(void) {
+    printf("{\n");
+    printf("  \"description\": \"Tolerance levels from the native models in src/tolerance_model.h "
+           "(float32), starting at level 0. tests/test_tolerance_vectors.py checks "
+           "tolerance_models.py against them. Generated by tests/data/tolerance_vectors.c.\",\n");
+    printf("  \"cases\": [\n");
+    for (int c = 0; c < N_CASES; c++) {
+        const VectorCase* vc = &CASES[c];
+        ToleranceConfig config;
+        if (tolerance_config_parse(&config, vc->spec) != 0) return 1;
+        ToleranceModel model;
+        tolerance_model_init(&model, &config, vc->dt_days);
+
+        float level[MAX_STEPS], current = 0;
+        for (int i = 0; i < vc->n; i++) {
+            current = tolerance_update(config.kind, &model, current, vc->exposure[i]);
+            level[i] = current;
+        }
+
+        printf("    {\n      \"config\": ");
+        print_config(vc->spec);
+        printf(",\n      \"dt_days\": %g,\n      \"exposure\": ", vc->dt_days);
+        print_values(vc->exposure, vc->n);
+        printf(",\n      \"level\": ");
+        print_values(level, vc->n);
+        printf("\n    }%s\n", c + 1 < N_CASES ? "," : "");
+    }
+    printf("  ]\n}\n");
+    return 0;
+}
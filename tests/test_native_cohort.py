@@ -0,0 +1,71 @@
+import sys
+from pathlib import Path
+import unittest
+import numpy as np
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.append(str(ROOT / "src"))
+
+import native_cohort
+from patient_simulation_100k import (
+    PatientGenerator,
+    PatientGenerationConfig,
+    PatientProfile,
+)
+from scenarios import parse_cohort_spec, build_generation_config
+
+
+@unittest.skipUnless(native_cohort.native_available(), "libzp_cohort.so not built")
+class NativeCohortTests(unittest.TestCase):
+    def test_seed_none_draws_fresh_cohorts(self):
+        first = native_cohort.generate_cohort(500, seed=None)
+        second = native_cohort.generate_cohort(500, seed=None)
+        self.assertEqual(len(first), 500)
+        self.assertNotEqual(first.columns["weight"][:], second.columns["weight"][:])
+
+    def test_invalid_range_is_rejected(self):
+        with self.assertRaises(ValueError):
+            native_cohort.generate_cohort(10, seed=1, first=-1)
+        with self.assertRaises(ValueError):
+            native_cohort.generate_cohort(10, seed=1, first=2**31 - 5)
+
+    def test_ranges_match_whole_cohort(self):
+        whole = native_cohort.generate_cohort(1000, seed=7)
+        tail = native_cohort.generate_cohort(400, seed=7, first=600)
+        for name in whole.columns:
+            self.assertEqual(whole.columns[name][600:], tail.columns[name][:], name)
+        other = native_cohort.generate_cohort(1000, seed=8)
+        self.assertNotEqual(whole.columns["weight"][:], other.columns["weight"][:])
+
+    def test_marginals_follow_configuration(self):
+        cohort = parse_cohort_spec("n=50000,age=60±10,renal=0.3,hepatic=0.1,seed=42")
+        cfg = build_generation_config(cohort)
+        columns = native_cohort.generate_cohort(cohort.n, cohort.seed, cfg).columns
+
+        # Beta(2, 3) over 18-90, truncated to whole years
+        self.assertAlmostEqual(np.mean(columns["age"][:]), 18 + 0.4 * 72 - 0.5, delta=0.5)
+        self.assertAlmostEqual(np.mean(columns["male"][:]), 0.5, delta=0.01)
+        # Beta(3, 2) * 10
+        self.assertAlmostEqual(np.mean(columns["pain_severity"][:]), 6.0, delta=0.05)
+
+        kidney = list(cfg.comorbidity_prevalence).index("kidney_disease")
+        kidney_rate = np.mean([bits >> kidney & 1 for bits in columns["conditions"][:]])
+        self.assertGreater(kidney_rate, 0.3)
+        self.assertLess(kidney_rate, 0.4)
+
+    def test_generate_population_returns_profiles(self):
+        patients = PatientGenerator.generate_population(300, seed=99, native=True)
+        self.assertEqual(len(patients), 300)
+        self.assertIsInstance(patients[0], PatientProfile)
+        self.assertEqual([p.patient_id for p in patients], list(range(300)))
+
+        names = {med.name for med in PatientGenerationConfig().pre_existing_medications.values()}
+        taken = [m for p in patients for m in p.medications]
+        self.assertTrue(taken)
+        self.assertTrue(set(taken) <= names)
+        for p in patients:
+            if "liver_disease" not in p.comorbidities and "kidney_disease" not in p.comorbidities:
+                self.assertGreater(p.metabolism_rate, 0.0)
+            self.assertAlmostEqual(
+                p.baseline_tolerance, p.medication_effects["baseline_tolerance"]
+            )
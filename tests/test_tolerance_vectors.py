@@ -0,0 +1,24 @@
+import json
+import math
+import sys
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.append(str(ROOT / "src"))
+
+from tolerance_models import make_tolerance_model, ToleranceState
+
+VECTORS = ROOT / "tests" / "data" / "tolerance_vectors.json"
+
+
+def test_tolerance_models_match_native_vectors():
+    cases = json.loads(VECTORS.read_text())["cases"]
+    assert cases
+    for case in cases:
+        model = make_tolerance_model(case["config"])
+        state = ToleranceState(level=0.0, ceiling=case["config"].get("max_factor", 3.0))
+        for exposure, expected in zip(case["exposure"], case["level"]):
+            state = model.update(state, exposure=exposure, dt_days=case["dt_days"])
+            # Native levels are float32
+            assert math.isclose(state.level, expected, rel_tol=1e-5, abs_tol=1e-6), (
+                case["config"], exposure, state.level, expected)